@@ -0,0 +1,328 @@
+#pragma once
+
+#include "graph.h"
+#include "parallel.h"
+#include "route_engine.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <numeric>
+#include <optional>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace graph {
+
+// A* с ориентирами (ALT). При построении выбирается несколько вершин-
+// ориентиров и для каждой вершины запоминаются расстояния от ориентира и
+// до него — O(L*V) памяти. Из неравенства треугольника
+//     d(v, t) >= d(v, L) - d(t, L)   и   d(v, t) >= d(L, t) - d(L, v)
+// получается нижняя оценка оставшегося пути, которая направляет поиск к
+// цели и позволяет не обходить большую часть графа.
+template <typename Weight>
+class AltRouter : public RouteEngine<Weight> {
+private:
+    using Graph = DirectedWeightedGraph<Weight>;
+    static_assert(std::numeric_limits<Weight>::has_infinity, "Weight should have an infinity value");
+
+public:
+    static constexpr size_t DEFAULT_LANDMARK_COUNT = 16;
+
+    explicit AltRouter(const Graph& graph, size_t landmark_count = DEFAULT_LANDMARK_COUNT);
+
+    using RouteInfo = graph::RouteInfo<Weight>;
+
+    std::optional<RouteInfo> BuildRoute(VertexId from, VertexId to) const override;
+
+    const std::vector<VertexId>& GetLandmarks() const {
+        return landmarks_;
+    }
+
+    SearchStats GetSearchStats() const override {
+        return counters_.Get();
+    }
+
+private:
+    // В запросе участвуют только ориентиры с лучшими оценками для пары
+    // from-to: остальные почти никогда не дают максимум, а считать их дорого
+    static constexpr size_t ACTIVE_LANDMARK_COUNT = 4;
+    static constexpr Weight ZERO_WEIGHT{};
+    static constexpr Weight INFINITE_WEIGHT = std::numeric_limits<Weight>::infinity();
+    static constexpr EdgeId NO_EDGE = static_cast<EdgeId>(-1);
+
+    struct SearchState {
+        std::vector<Weight> weights;
+        std::vector<Weight> heuristics;
+        std::vector<EdgeId> prev_edges;
+        std::vector<uint32_t> marks;
+        std::vector<std::pair<Weight, VertexId>> queue;  // ключ — вес плюс оценка
+        std::vector<size_t> active_landmarks;
+        uint32_t current_mark = 0;
+
+        void Prepare(size_t vertex_count) {
+            if (marks.size() < vertex_count) {
+                weights.resize(vertex_count);
+                heuristics.resize(vertex_count);
+                prev_edges.resize(vertex_count);
+                marks.resize(vertex_count, 0);
+            }
+            if (++current_mark == 0) {
+                std::fill(marks.begin(), marks.end(), 0);
+                current_mark = 1;
+            }
+            queue.clear();
+            active_landmarks.clear();
+        }
+
+        bool IsReached(VertexId vertex) const {
+            return marks[vertex] == current_mark;
+        }
+    };
+
+    static SearchState& GetSearchState() {
+        static thread_local SearchState state;
+        return state;
+    }
+
+    // Дейкстра из source по исходящим (или входящим, если backward) рёбрам;
+    // недостижимые вершины получают бесконечность
+    std::vector<Weight> ComputeDistances(VertexId source, bool backward) const;
+    void SelectLandmarks(size_t landmark_count);
+    // Нижняя оценка d(vertex, to) по одному ориентиру
+    Weight GetLandmarkBound(size_t landmark, VertexId vertex, VertexId to) const;
+    Weight GetHeuristic(const std::vector<size_t>& active_landmarks, VertexId vertex, VertexId to) const;
+
+    const Graph& graph_;
+    std::vector<VertexId> landmarks_;
+    // Расстояния от ориентиров и до них: вершина v занимает позиции
+    // [v * L, (v + 1) * L), чтобы оценка читала одну строку
+    std::vector<Weight> from_landmarks_;
+    std::vector<Weight> to_landmarks_;
+    SearchCounters counters_;
+};
+
+template <typename Weight>
+AltRouter<Weight>::AltRouter(const Graph& graph, size_t landmark_count)
+    : graph_(graph)
+{
+    for (EdgeId edge_id = 0; edge_id < graph.GetEdgeCount(); ++edge_id) {
+        if (graph.GetEdge(edge_id).weight < ZERO_WEIGHT) {
+            throw std::domain_error("Edges' weights should be non-negative");
+        }
+    }
+    SelectLandmarks(landmark_count);
+}
+
+template <typename Weight>
+std::vector<Weight> AltRouter<Weight>::ComputeDistances(VertexId source, bool backward) const {
+    std::vector<Weight> distances(graph_.GetVertexCount(), INFINITE_WEIGHT);
+    std::vector<std::pair<Weight, VertexId>> queue;
+    const auto cmp = std::greater<std::pair<Weight, VertexId>>{};
+
+    distances[source] = ZERO_WEIGHT;
+    queue.emplace_back(ZERO_WEIGHT, source);
+    while (!queue.empty()) {
+        std::pop_heap(queue.begin(), queue.end(), cmp);
+        const auto [weight, vertex] = queue.back();
+        queue.pop_back();
+        if (distances[vertex] < weight) {
+            continue;
+        }
+        const auto relax = [&, weight = weight](EdgeId, VertexId neighbor, Weight edge_weight) {
+            const Weight candidate_weight = weight + edge_weight;
+            if (candidate_weight < distances[neighbor]) {
+                distances[neighbor] = candidate_weight;
+                queue.emplace_back(candidate_weight, neighbor);
+                std::push_heap(queue.begin(), queue.end(), cmp);
+            }
+        };
+        if (backward) {
+            graph_.ForEachIncomingEdge(vertex, relax);
+        } else {
+            graph_.ForEachIncidentEdge(vertex, relax);
+        }
+    }
+    return distances;
+}
+
+template <typename Weight>
+void AltRouter<Weight>::SelectLandmarks(size_t landmark_count) {
+    const size_t vertex_count = graph_.GetVertexCount();
+
+    // Ориентиром может быть только вершина, через которую проходят пути:
+    // у неё есть и входящие, и исходящие рёбра
+    std::vector<bool> has_incoming(vertex_count, false);
+    std::vector<bool> has_outgoing(vertex_count, false);
+    for (EdgeId edge_id = 0; edge_id < graph_.GetEdgeCount(); ++edge_id) {
+        has_outgoing[graph_.GetEdge(edge_id).from] = true;
+        has_incoming[graph_.GetEdge(edge_id).to] = true;
+    }
+    std::vector<VertexId> candidates;
+    for (VertexId vertex = 0; vertex < vertex_count; ++vertex) {
+        if (has_incoming[vertex] && has_outgoing[vertex]) {
+            candidates.push_back(vertex);
+        }
+    }
+    if (candidates.empty() || landmark_count == 0) {
+        return;
+    }
+
+    // Выбор «самой дальней» вершины: следующий ориентир — кандидат с
+    // наибольшим расстоянием до ближайшего из уже выбранных; недостижимые
+    // вершины (другие компоненты связности) выбираются в первую очередь.
+    // Первый ориентир — самая дальняя вершина от первого кандидата.
+    std::vector<Weight> min_distances = ComputeDistances(candidates.front(), false);
+    std::vector<std::vector<Weight>> forward_distances;
+    while (landmarks_.size() < std::min(landmark_count, candidates.size())) {
+        VertexId best = candidates.front();
+        Weight best_distance = -INFINITE_WEIGHT;
+        for (const VertexId vertex : candidates) {
+            if (min_distances[vertex] > best_distance) {
+                best = vertex;
+                best_distance = min_distances[vertex];
+            }
+        }
+        if (best_distance == ZERO_WEIGHT && !landmarks_.empty()) {
+            break;  // все кандидаты уже ориентиры
+        }
+        if (landmarks_.empty()) {
+            min_distances.assign(vertex_count, INFINITE_WEIGHT);
+        }
+        landmarks_.push_back(best);
+        forward_distances.push_back(ComputeDistances(best, false));
+        for (VertexId vertex = 0; vertex < vertex_count; ++vertex) {
+            min_distances[vertex] = std::min(min_distances[vertex], forward_distances.back()[vertex]);
+        }
+    }
+
+    // Обратные расстояния независимы и считаются параллельно
+    const size_t count = landmarks_.size();
+    std::vector<std::vector<Weight>> backward_distances(count);
+    parallel::ParallelFor(count, [&](size_t landmark) {
+        backward_distances[landmark] = ComputeDistances(landmarks_[landmark], true);
+    });
+
+    from_landmarks_.resize(vertex_count * count);
+    to_landmarks_.resize(vertex_count * count);
+    for (VertexId vertex = 0; vertex < vertex_count; ++vertex) {
+        for (size_t landmark = 0; landmark < count; ++landmark) {
+            from_landmarks_[vertex * count + landmark] = forward_distances[landmark][vertex];
+            to_landmarks_[vertex * count + landmark] = backward_distances[landmark][vertex];
+        }
+    }
+}
+
+template <typename Weight>
+Weight AltRouter<Weight>::GetLandmarkBound(size_t landmark, VertexId vertex, VertexId to) const {
+    const size_t count = landmarks_.size();
+    const Weight vertex_to_landmark = to_landmarks_[vertex * count + landmark];
+    const Weight target_to_landmark = to_landmarks_[to * count + landmark];
+    const Weight landmark_to_vertex = from_landmarks_[vertex * count + landmark];
+    const Weight landmark_to_target = from_landmarks_[to * count + landmark];
+
+    Weight bound = ZERO_WEIGHT;
+    // Из цели ориентир достижим, а из вершины нет — значит, и цель недостижима
+    if (target_to_landmark != INFINITE_WEIGHT) {
+        bound = std::max(bound, vertex_to_landmark - target_to_landmark);
+    }
+    // Цель достижима из ориентира только в обход вершины — аналогично
+    if (landmark_to_vertex != INFINITE_WEIGHT) {
+        bound = std::max(bound, landmark_to_target - landmark_to_vertex);
+    }
+    return bound;
+}
+
+template <typename Weight>
+Weight AltRouter<Weight>::GetHeuristic(const std::vector<size_t>& active_landmarks, VertexId vertex,
+                                       VertexId to) const {
+    Weight heuristic = ZERO_WEIGHT;
+    for (const size_t landmark : active_landmarks) {
+        heuristic = std::max(heuristic, GetLandmarkBound(landmark, vertex, to));
+    }
+    return heuristic;
+}
+
+template <typename Weight>
+std::optional<typename AltRouter<Weight>::RouteInfo> AltRouter<Weight>::BuildRoute(VertexId from,
+                                                                                   VertexId to) const {
+    const size_t vertex_count = graph_.GetVertexCount();
+    if (from >= vertex_count || to >= vertex_count) {
+        throw std::out_of_range("Vertex id is out of range");
+    }
+
+    SearchState& state = GetSearchState();
+    state.Prepare(vertex_count);
+
+    // Активные ориентиры — с наибольшей оценкой d(from, to)
+    std::vector<std::pair<Weight, size_t>> landmark_bounds;
+    for (size_t landmark = 0; landmark < landmarks_.size(); ++landmark) {
+        landmark_bounds.emplace_back(GetLandmarkBound(landmark, from, to), landmark);
+    }
+    const size_t active_count = std::min(ACTIVE_LANDMARK_COUNT, landmark_bounds.size());
+    std::partial_sort(landmark_bounds.begin(), landmark_bounds.begin() + active_count, landmark_bounds.end(),
+                      std::greater<std::pair<Weight, size_t>>{});
+    for (size_t i = 0; i < active_count; ++i) {
+        state.active_landmarks.push_back(landmark_bounds[i].second);
+    }
+    if (active_count > 0 && landmark_bounds.front().first == INFINITE_WEIGHT) {
+        counters_.Add(0);
+        return std::nullopt;
+    }
+
+    auto& queue = state.queue;
+    const auto cmp = std::greater<std::pair<Weight, VertexId>>{};
+    const auto reach = [&](VertexId vertex, Weight weight, EdgeId prev_edge) {
+        if (!state.IsReached(vertex)) {
+            state.marks[vertex] = state.current_mark;
+            state.heuristics[vertex] = GetHeuristic(state.active_landmarks, vertex, to);
+        }
+        state.weights[vertex] = weight;
+        state.prev_edges[vertex] = prev_edge;
+        // Вершины, из которых цель заведомо недостижима, в очередь не попадают
+        if (state.heuristics[vertex] != INFINITE_WEIGHT) {
+            queue.emplace_back(weight + state.heuristics[vertex], vertex);
+            std::push_heap(queue.begin(), queue.end(), cmp);
+        }
+    };
+
+    reach(from, ZERO_WEIGHT, NO_EDGE);
+    size_t settled_count = 0;
+    while (!queue.empty()) {
+        std::pop_heap(queue.begin(), queue.end(), cmp);
+        const auto [key, vertex] = queue.back();
+        queue.pop_back();
+        // Устаревшая запись очереди: с тех пор вес вершины уменьшился
+        if (state.weights[vertex] + state.heuristics[vertex] < key) {
+            continue;
+        }
+        ++settled_count;
+        if (vertex == to) {
+            break;
+        }
+        const Weight weight = state.weights[vertex];
+        graph_.ForEachIncidentEdge(vertex, [&](EdgeId edge_id, VertexId edge_to, Weight edge_weight) {
+            const Weight candidate_weight = weight + edge_weight;
+            if (!state.IsReached(edge_to) || candidate_weight < state.weights[edge_to]) {
+                reach(edge_to, candidate_weight, edge_id);
+            }
+        });
+    }
+    counters_.Add(settled_count);
+
+    if (!state.IsReached(to)) {
+        return std::nullopt;
+    }
+    std::vector<EdgeId> edges;
+    for (EdgeId edge_id = state.prev_edges[to]; edge_id != NO_EDGE;
+         edge_id = state.prev_edges[graph_.GetEdge(edge_id).from]) {
+        edges.push_back(edge_id);
+    }
+    std::reverse(edges.begin(), edges.end());
+
+    return RouteInfo{state.weights[to], std::move(edges)};
+}
+
+}  // namespace graph
@@ -0,0 +1,238 @@
+#pragma once
+
+#include "graph.h"
+#include "parallel.h"
+#include "route_engine.h"
+
+#include <algorithm>
+#include <limits>
+#include <optional>
+#include <stdexcept>
+#include <type_traits>
+#include <vector>
+
+// Без флагов -mavx2/-march GCC на -O2 не векторизует ядро RelaxRow, поэтому
+// на x86-64 оно собирается в двух вариантах (AVX2 и базовом), а нужный
+// выбирается при загрузке программы. Замер: tests/blocked_router_bench.cpp
+#if defined(__GNUC__) && !defined(__clang__) && defined(__x86_64__) && defined(__linux__)
+#define BLOCKED_ROUTER_TARGET_CLONES __attribute__((target_clones("avx2", "default")))
+#else
+#define BLOCKED_ROUTER_TARGET_CLONES
+#endif
+
+namespace graph {
+
+// Предрасчёт всех пар кратчайших путей блочным алгоритмом Флойда-Уоршелла.
+// Веса хранятся в плотной матрице с бесконечностью вместо std::optional,
+// последние рёбра путей — в отдельной матрице. Матрица режется на квадратные
+// блоки, помещающиеся в кэш; для каждого блока-посредника сначала
+// обновляется диагональный блок, затем блоки его строки и столбца, затем
+// все остальные. Блоки одного этапа независимы и считаются параллельно,
+// а внутренний цикл по строке блока — это min-plus без ветвлений, который
+// компилятор векторизует.
+template <typename Weight>
+class BlockedRouter : public RouteEngine<Weight> {
+private:
+    using Graph = DirectedWeightedGraph<Weight>;
+    static_assert(std::numeric_limits<Weight>::has_infinity, "Weight should have an infinity value");
+
+public:
+    explicit BlockedRouter(const Graph& graph);
+    // Готовые матрицы во внешней памяти (например, в отображённом файле),
+    // которая должна жить дольше роутера
+    BlockedRouter(const Graph& graph, const Weight* weights, const EdgeId* prev_edges);
+
+    using RouteInfo = graph::RouteInfo<Weight>;
+
+    static constexpr EdgeId NO_EDGE = static_cast<EdgeId>(-1);
+
+    std::optional<RouteInfo> BuildRoute(VertexId from, VertexId to) const override;
+
+    // Сторона квадратных матриц весов и рёбер: число вершин,
+    // дополненное до кратного размеру блока
+    static size_t GetDimension(size_t vertex_count) {
+        return (vertex_count + BLOCK_SIZE - 1) / BLOCK_SIZE * BLOCK_SIZE;
+    }
+
+    const Weight* GetWeights() const {
+        return weights_;
+    }
+
+    const EdgeId* GetPrevEdges() const {
+        return prev_edges_;
+    }
+
+private:
+    static constexpr size_t BLOCK_SIZE = 64;
+    static constexpr Weight ZERO_WEIGHT{};
+    static constexpr Weight INFINITE_WEIGHT = std::numeric_limits<Weight>::infinity();
+
+    size_t Index(VertexId from, VertexId to) const {
+        return from * dimension_ + to;
+    }
+
+    void RelaxBlock(size_t block_row, size_t block_col, size_t block_through);
+    // Внутреннее ядро min-plus по строке блока. Указатели не пересекаются
+    // (строка посредника пропускается), что позволяет векторизацию.
+    static void RelaxRow(Weight weight_to_through,
+                         const Weight* __restrict through_weights,
+                         const EdgeId* __restrict through_edges,
+                         Weight* __restrict row_weights,
+                         EdgeId* __restrict row_edges);
+
+    const Graph& graph_;
+    size_t vertex_count_ = 0;
+    size_t dimension_ = 0;  // число вершин, дополненное до кратного BLOCK_SIZE
+    // Собственные матрицы, если они посчитаны этим роутером, и указатели
+    // на матрицы, по которым отвечают запросы (свои или внешние)
+    std::vector<Weight> weights_storage_;
+    std::vector<EdgeId> prev_edges_storage_;
+    const Weight* weights_ = nullptr;
+    const EdgeId* prev_edges_ = nullptr;
+};
+
+template <typename Weight>
+BlockedRouter<Weight>::BlockedRouter(const Graph& graph)
+    : graph_(graph)
+    , vertex_count_(graph.GetVertexCount())
+    , dimension_(GetDimension(vertex_count_))
+    , weights_storage_(dimension_ * dimension_, INFINITE_WEIGHT)
+    , prev_edges_storage_(dimension_ * dimension_, NO_EDGE)
+    , weights_(weights_storage_.data())
+    , prev_edges_(prev_edges_storage_.data())
+{
+    for (VertexId vertex = 0; vertex < vertex_count_; ++vertex) {
+        weights_storage_[Index(vertex, vertex)] = ZERO_WEIGHT;
+        graph.ForEachIncidentEdge(vertex, [&](EdgeId edge_id, VertexId edge_to, Weight edge_weight) {
+            if (edge_weight < ZERO_WEIGHT) {
+                throw std::domain_error("Edges' weights should be non-negative");
+            }
+            const size_t index = Index(vertex, edge_to);
+            if (edge_weight < weights_storage_[index]) {
+                weights_storage_[index] = edge_weight;
+                prev_edges_storage_[index] = edge_id;
+            }
+        });
+    }
+
+    const size_t block_count = dimension_ / BLOCK_SIZE;
+    for (size_t through = 0; through < block_count; ++through) {
+        RelaxBlock(through, through, through);
+
+        // Блоки строки и столбца посредника зависят только от диагонального
+        parallel::ParallelFor(2 * block_count, [&](size_t task) {
+            const size_t other = task / 2;
+            if (other == through) {
+                return;
+            }
+            if (task % 2 == 0) {
+                RelaxBlock(through, other, through);
+            } else {
+                RelaxBlock(other, through, through);
+            }
+        });
+
+        // Остальные блоки зависят только от блоков строки и столбца;
+        // задача — полоса блоков одной строки
+        parallel::ParallelFor(block_count, [&](size_t block_row) {
+            if (block_row == through) {
+                return;
+            }
+            for (size_t block_col = 0; block_col < block_count; ++block_col) {
+                if (block_col != through) {
+                    RelaxBlock(block_row, block_col, through);
+                }
+            }
+        });
+    }
+}
+
+template <typename Weight>
+BlockedRouter<Weight>::BlockedRouter(const Graph& graph, const Weight* weights, const EdgeId* prev_edges)
+    : graph_(graph)
+    , vertex_count_(graph.GetVertexCount())
+    , dimension_(GetDimension(vertex_count_))
+    , weights_(weights)
+    , prev_edges_(prev_edges)
+{
+}
+
+template <typename Weight>
+void BlockedRouter<Weight>::RelaxBlock(size_t block_row, size_t block_col, size_t block_through) {
+    const size_t row_begin = block_row * BLOCK_SIZE;
+    const size_t col_begin = block_col * BLOCK_SIZE;
+    const size_t through_begin = block_through * BLOCK_SIZE;
+    // Пересчёт идёт только в собственных матрицах
+    Weight* weights = weights_storage_.data();
+    EdgeId* prev_edges = prev_edges_storage_.data();
+
+    for (size_t through = through_begin; through < through_begin + BLOCK_SIZE; ++through) {
+        const Weight* through_weights = &weights[Index(through, col_begin)];
+        const EdgeId* through_edges = &prev_edges[Index(through, col_begin)];
+        for (size_t row = row_begin; row < row_begin + BLOCK_SIZE; ++row) {
+            const Weight weight_to_through = weights[Index(row, through)];
+            if (weight_to_through == INFINITE_WEIGHT) {
+                continue;
+            }
+            // Строка посредника через саму себя не улучшается
+            if (row != through) {
+                RelaxRow(weight_to_through, through_weights, through_edges,
+                         &weights[Index(row, col_begin)], &prev_edges[Index(row, col_begin)]);
+            }
+        }
+    }
+}
+
+template <typename Weight>
+BLOCKED_ROUTER_TARGET_CLONES
+void BlockedRouter<Weight>::RelaxRow(Weight weight_to_through,
+                                     const Weight* __restrict through_weights,
+                                     const EdgeId* __restrict through_edges,
+                                     Weight* __restrict row_weights,
+                                     EdgeId* __restrict row_edges) {
+    // Все чтения безусловные, а запись — выбор из двух значений: так цикл
+    // сводится к сравнению и смешиванию векторов (на x86 — начиная с AVX2)
+    for (size_t col = 0; col < BLOCK_SIZE; ++col) {
+        const Weight candidate = weight_to_through + through_weights[col];
+        const Weight current = row_weights[col];
+        const EdgeId candidate_edge = through_edges[col];
+        const EdgeId current_edge = row_edges[col];
+        const bool is_better = candidate < current;
+        row_weights[col] = is_better ? candidate : current;
+        row_edges[col] = is_better ? candidate_edge : current_edge;
+    }
+}
+
+template <typename Weight>
+std::optional<typename BlockedRouter<Weight>::RouteInfo> BlockedRouter<Weight>::BuildRoute(VertexId from,
+                                                                                           VertexId to) const {
+    if (from >= vertex_count_ || to >= vertex_count_) {
+        throw std::out_of_range("Vertex id is out of range");
+    }
+    const Weight weight = weights_[Index(from, to)];
+    if (weight == INFINITE_WEIGHT) {
+        return std::nullopt;
+    }
+    // Простой путь короче числа вершин; более длинная цепочка или ребро не
+    // в ту вершину означают повреждённую внешнюю матрицу
+    std::vector<EdgeId> edges;
+    for (VertexId vertex = to; vertex != from;) {
+        const EdgeId edge_id = prev_edges_[Index(from, vertex)];
+        if (edge_id >= graph_.GetEdgeCount() || edges.size() == vertex_count_) {
+            throw std::runtime_error("Blocked route table is corrupted");
+        }
+        const auto edge = graph_.GetEdge(edge_id);
+        if (edge.to != vertex) {
+            throw std::runtime_error("Blocked route table is corrupted");
+        }
+        edges.push_back(edge_id);
+        vertex = edge.from;
+    }
+    std::reverse(edges.begin(), edges.end());
+
+    return RouteInfo{weight, std::move(edges)};
+}
+
+}  // namespace graph
+
+#undef BLOCKED_ROUTER_TARGET_CLONES
@@ -0,0 +1,126 @@
+#pragma once
+
+#include "dijkstra_router.h"
+#include "graph.h"
+#include "parallel.h"
+#include "route_engine.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <optional>
+#include <stdexcept>
+#include <vector>
+
+namespace graph {
+
+// Предрасчёт всех пар с минимальной памятью: для каждой пары вершин
+// хранится только последнее ребро кратчайшего пути в 4 байтах (против
+// ~32 байт на ячейку у Router). Вес пути не хранится, а пересчитывается
+// при восстановлении маршрута суммированием весов рёбер в типе Weight,
+// поэтому ответ совпадает с весом пути без потерь точности.
+// Таблица заполняется построчно запуском Дейкстры из каждой вершины,
+// строки независимы и считаются параллельно.
+template <typename Weight>
+class CompactRouter : public RouteEngine<Weight> {
+private:
+    using Graph = DirectedWeightedGraph<Weight>;
+
+public:
+    using CompactEdgeId = uint32_t;
+    static constexpr CompactEdgeId NO_EDGE = std::numeric_limits<CompactEdgeId>::max();
+
+    explicit CompactRouter(const Graph& graph);
+    // Готовая таблица во внешней памяти (например, в отображённом файле),
+    // которая должна жить дольше роутера
+    CompactRouter(const Graph& graph, const CompactEdgeId* prev_edges);
+
+    using RouteInfo = graph::RouteInfo<Weight>;
+
+    std::optional<RouteInfo> BuildRoute(VertexId from, VertexId to) const override;
+
+    // Таблица последних рёбер: GetVertexCount()^2 элементов по строкам
+    const CompactEdgeId* GetTable() const {
+        return prev_edges_;
+    }
+
+private:
+    static constexpr Weight ZERO_WEIGHT{};
+
+    size_t Index(VertexId from, VertexId to) const {
+        return from * vertex_count_ + to;
+    }
+
+    const Graph& graph_;
+    size_t vertex_count_ = 0;
+    std::vector<CompactEdgeId> storage_;
+    const CompactEdgeId* prev_edges_ = nullptr;
+};
+
+template <typename Weight>
+CompactRouter<Weight>::CompactRouter(const Graph& graph)
+    : graph_(graph)
+    , vertex_count_(graph.GetVertexCount())
+{
+    if (graph.GetEdgeCount() >= NO_EDGE) {
+        throw std::length_error("Too many edges for compact route table");
+    }
+    // Проверяет веса рёбер на неотрицательность
+    const DijkstraRouter<Weight> dijkstra(graph);
+
+    storage_.assign(vertex_count_ * vertex_count_, NO_EDGE);
+    prev_edges_ = storage_.data();
+    parallel::ParallelFor(vertex_count_, [&](size_t from) {
+        CompactEdgeId* row = &storage_[Index(from, 0)];
+        dijkstra.ForEachShortestPath(from, [row](VertexId vertex, Weight, EdgeId prev_edge) {
+            if (prev_edge != static_cast<EdgeId>(-1)) {
+                row[vertex] = static_cast<CompactEdgeId>(prev_edge);
+            }
+        });
+    });
+}
+
+template <typename Weight>
+CompactRouter<Weight>::CompactRouter(const Graph& graph, const CompactEdgeId* prev_edges)
+    : graph_(graph)
+    , vertex_count_(graph.GetVertexCount())
+    , prev_edges_(prev_edges)
+{
+}
+
+template <typename Weight>
+std::optional<typename CompactRouter<Weight>::RouteInfo> CompactRouter<Weight>::BuildRoute(VertexId from,
+                                                                                           VertexId to) const {
+    if (from >= vertex_count_ || to >= vertex_count_) {
+        throw std::out_of_range("Vertex id is out of range");
+    }
+    if (from != to && prev_edges_[Index(from, to)] == NO_EDGE) {
+        return std::nullopt;
+    }
+
+    // Простой путь короче числа вершин; более длинная цепочка или ребро не
+    // в ту вершину означают повреждённую внешнюю таблицу
+    std::vector<EdgeId> edges;
+    for (VertexId vertex = to; vertex != from;) {
+        const EdgeId edge_id = prev_edges_[Index(from, vertex)];
+        if (edge_id >= graph_.GetEdgeCount() || edges.size() == vertex_count_) {
+            throw std::runtime_error("Compact route table is corrupted");
+        }
+        const auto edge = graph_.GetEdge(edge_id);
+        if (edge.to != vertex) {
+            throw std::runtime_error("Compact route table is corrupted");
+        }
+        edges.push_back(edge_id);
+        vertex = edge.from;
+    }
+    std::reverse(edges.begin(), edges.end());
+
+    // Суммирование в порядке пути повторяет вычисление веса в Дейкстре
+    Weight weight = ZERO_WEIGHT;
+    for (const EdgeId edge_id : edges) {
+        weight += graph_.GetEdge(edge_id).weight;
+    }
+    return RouteInfo{weight, std::move(edges)};
+}
+
+}  // namespace graph
@@ -0,0 +1,204 @@
+#pragma once
+
+#include "graph.h"
+#include "route_engine.h"
+
+#include <algorithm>
+#include <functional>
+#include <memory>
+#include <numeric>
+#include <optional>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace graph {
+
+// Обёртка движка, которая делит граф на компоненты слабой связности и
+// строит отдельный движок на подграфе каждой компоненты. Между разными
+// компонентами путей нет, поэтому такие запросы отвечаются за O(1), а
+// таблицы всех пар занимают сумму квадратов размеров компонент вместо
+// квадрата числа вершин. Вершины и рёбра подграфа идут в исходном
+// порядке, поэтому движок выбирает те же пути, что и на всём графе.
+template <typename Weight>
+class ComponentRouter : public RouteEngine<Weight> {
+private:
+    using Graph = DirectedWeightedGraph<Weight>;
+
+public:
+    using EngineFactory = std::function<std::unique_ptr<RouteEngine<Weight>>(const Graph&)>;
+
+    ComponentRouter(const Graph& graph, const EngineFactory& make_engine);
+
+    using RouteInfo = graph::RouteInfo<Weight>;
+
+    std::optional<RouteInfo> BuildRoute(VertexId from, VertexId to) const override;
+    std::vector<std::optional<RouteInfo>> BuildRoutes(VertexId from,
+                                                      const std::vector<VertexId>& targets) const override;
+    SearchStats GetSearchStats() const override;
+
+    size_t GetComponentCount() const {
+        return components_.size();
+    }
+
+private:
+    struct Component {
+        // Подграф с локальными номерами; если компонента одна, он пуст и
+        // движок работает прямо на исходном графе
+        Graph graph;
+        std::vector<EdgeId> edge_ids;  // локальный номер ребра -> исходный
+        std::unique_ptr<RouteEngine<Weight>> engine;
+    };
+
+    void CheckVertex(VertexId vertex) const;
+    RouteInfo ToGlobal(const Component& component, RouteInfo route) const;
+
+    bool is_split_ = false;
+    std::vector<size_t> component_ids_;  // по вершинам
+    std::vector<VertexId> local_ids_;    // номер вершины в подграфе компоненты
+    std::vector<Component> components_;
+};
+
+template <typename Weight>
+ComponentRouter<Weight>::ComponentRouter(const Graph& graph, const EngineFactory& make_engine) {
+    const size_t vertex_count = graph.GetVertexCount();
+
+    // Система непересекающихся множеств по рёбрам без учёта направления
+    std::vector<VertexId> parents(vertex_count);
+    std::iota(parents.begin(), parents.end(), VertexId{0});
+    const auto find_root = [&parents](VertexId vertex) {
+        while (parents[vertex] != vertex) {
+            parents[vertex] = parents[parents[vertex]];
+            vertex = parents[vertex];
+        }
+        return vertex;
+    };
+    for (EdgeId edge_id = 0; edge_id < graph.GetEdgeCount(); ++edge_id) {
+        const auto& edge = graph.GetEdge(edge_id);
+        const VertexId from_root = find_root(edge.from);
+        const VertexId to_root = find_root(edge.to);
+        if (from_root != to_root) {
+            parents[std::max(from_root, to_root)] = std::min(from_root, to_root);
+        }
+    }
+
+    // Компоненты нумеруются по первой вершине, вершины внутри — по возрастанию
+    constexpr size_t NO_COMPONENT = static_cast<size_t>(-1);
+    std::vector<size_t> root_components(vertex_count, NO_COMPONENT);
+    std::vector<size_t> component_sizes;
+    component_ids_.resize(vertex_count);
+    local_ids_.resize(vertex_count);
+    for (VertexId vertex = 0; vertex < vertex_count; ++vertex) {
+        size_t& component_id = root_components[find_root(vertex)];
+        if (component_id == NO_COMPONENT) {
+            component_id = component_sizes.size();
+            component_sizes.push_back(0);
+        }
+        component_ids_[vertex] = component_id;
+        local_ids_[vertex] = component_sizes[component_id]++;
+    }
+
+    components_.resize(component_sizes.size());
+    is_split_ = components_.size() > 1;
+    if (!is_split_) {
+        if (!components_.empty()) {
+            components_.front().engine = make_engine(graph);
+        }
+        return;
+    }
+
+    for (size_t component_id = 0; component_id < components_.size(); ++component_id) {
+        components_[component_id].graph = Graph(component_sizes[component_id]);
+    }
+    for (EdgeId edge_id = 0; edge_id < graph.GetEdgeCount(); ++edge_id) {
+        Edge<Weight> edge = graph.GetEdge(edge_id);
+        Component& component = components_[component_ids_[edge.from]];
+        edge.from = local_ids_[edge.from];
+        edge.to = local_ids_[edge.to];
+        component.graph.AddEdge(edge);
+        component.edge_ids.push_back(edge_id);
+    }
+    // Движки создаются после всех подграфов: они хранят ссылки на них
+    for (Component& component : components_) {
+        component.graph.Freeze();
+        component.engine = make_engine(component.graph);
+    }
+}
+
+template <typename Weight>
+void ComponentRouter<Weight>::CheckVertex(VertexId vertex) const {
+    if (vertex >= component_ids_.size()) {
+        throw std::out_of_range("Vertex id is out of range");
+    }
+}
+
+template <typename Weight>
+typename ComponentRouter<Weight>::RouteInfo ComponentRouter<Weight>::ToGlobal(const Component& component,
+                                                                              RouteInfo route) const {
+    if (is_split_) {
+        for (EdgeId& edge_id : route.edges) {
+            edge_id = component.edge_ids[edge_id];
+        }
+    }
+    return route;
+}
+
+template <typename Weight>
+std::optional<typename ComponentRouter<Weight>::RouteInfo> ComponentRouter<Weight>::BuildRoute(VertexId from,
+                                                                                               VertexId to) const {
+    CheckVertex(from);
+    CheckVertex(to);
+    if (component_ids_[from] != component_ids_[to]) {
+        return std::nullopt;
+    }
+    const Component& component = components_[component_ids_[from]];
+    auto route = component.engine->BuildRoute(local_ids_[from], local_ids_[to]);
+    if (!route) {
+        return std::nullopt;
+    }
+    return ToGlobal(component, std::move(*route));
+}
+
+template <typename Weight>
+std::vector<std::optional<typename ComponentRouter<Weight>::RouteInfo>> ComponentRouter<Weight>::BuildRoutes(
+        VertexId from, const std::vector<VertexId>& targets) const {
+    CheckVertex(from);
+    const size_t component_id = component_ids_[from];
+    const Component& component = components_[component_id];
+
+    // Движку компоненты передаются только цели из неё
+    std::vector<VertexId> local_targets;
+    std::vector<size_t> target_indices;
+    for (size_t i = 0; i < targets.size(); ++i) {
+        CheckVertex(targets[i]);
+        if (component_ids_[targets[i]] == component_id) {
+            local_targets.push_back(local_ids_[targets[i]]);
+            target_indices.push_back(i);
+        }
+    }
+
+    std::vector<std::optional<RouteInfo>> routes(targets.size());
+    if (local_targets.empty()) {
+        return routes;
+    }
+    auto local_routes = component.engine->BuildRoutes(local_ids_[from], local_targets);
+    for (size_t k = 0; k < local_routes.size(); ++k) {
+        if (local_routes[k]) {
+            routes[target_indices[k]] = ToGlobal(component, std::move(*local_routes[k]));
+        }
+    }
+    return routes;
+}
+
+template <typename Weight>
+SearchStats ComponentRouter<Weight>::GetSearchStats() const {
+    SearchStats stats;
+    for (const Component& component : components_) {
+        const SearchStats component_stats = component.engine->GetSearchStats();
+        stats.queries += component_stats.queries;
+        stats.settled_vertices += component_stats.settled_vertices;
+    }
+    return stats;
+}
+
+}  // namespace graph
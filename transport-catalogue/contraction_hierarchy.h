@@ -0,0 +1,505 @@
+#pragma once
+
+#include "graph.h"
+#include "route_engine.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include <queue>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace graph {
+
+// Маршрутизатор на иерархиях сжатия (Contraction Hierarchies).
+// При построении вершины по очереди «сжимаются»: вершина удаляется из графа,
+// а кратчайшие пути через неё сохраняются рёбрами-шорткатами. Запрос — это
+// двунаправленная Дейкстра, которая ходит только «вверх» по порядку сжатия
+// и поэтому просматривает лишь малую часть графа. Шорткаты при восстановлении
+// пути раскрываются обратно в исходные рёбра графа.
+template <typename Weight>
+class ContractionHierarchyRouter : public RouteEngine<Weight> {
+private:
+    using Graph = DirectedWeightedGraph<Weight>;
+
+public:
+    explicit ContractionHierarchyRouter(const Graph& graph);
+
+    using RouteInfo = graph::RouteInfo<Weight>;
+
+    std::optional<RouteInfo> BuildRoute(VertexId from, VertexId to) const override;
+
+    size_t GetShortcutCount() const {
+        return shortcut_count_;
+    }
+
+private:
+    static constexpr Weight ZERO_WEIGHT{};
+    static constexpr EdgeId NO_EDGE = static_cast<EdgeId>(-1);
+    static constexpr VertexId NO_VERTEX = static_cast<VertexId>(-1);
+    // Ограничение на число вершин, просматриваемых при поиске свидетеля.
+    // Если свидетель не найден, добавляется лишний (но корректный) шорткат.
+    // Для оценки приоритета хватает грубого поиска.
+    static constexpr size_t WITNESS_SETTLE_LIMIT = 500;
+    static constexpr size_t SIMULATION_SETTLE_LIMIT = 30;
+
+    // Ребро иерархии: исходное ребро графа или шорткат из двух рёбер иерархии
+    struct HierarchyEdge {
+        VertexId from;
+        VertexId to;
+        Weight weight;
+        EdgeId original;                 // NO_EDGE для шорткатов
+        EdgeId first_half = NO_EDGE;     // from -> середина
+        EdgeId second_half = NO_EDGE;    // середина -> to
+        bool replaced = false;           // вытеснено более лёгким шорткатом
+    };
+
+    // Ребро в списке смежности поиска: сосед и ребро иерархии
+    struct Arc {
+        VertexId neighbor;
+        EdgeId edge;
+    };
+
+    // Буферы одного направления поиска; разметка посещённых — как в DijkstraRouter
+    struct SearchSide {
+        std::vector<Weight> weights;
+        std::vector<EdgeId> prev_edges;
+        std::vector<uint32_t> marks;
+        std::vector<std::pair<Weight, VertexId>> queue;
+        uint32_t current_mark = 0;
+
+        void Prepare(size_t vertex_count) {
+            if (marks.size() < vertex_count) {
+                weights.resize(vertex_count);
+                prev_edges.resize(vertex_count);
+                marks.resize(vertex_count, 0);
+            }
+            if (++current_mark == 0) {
+                std::fill(marks.begin(), marks.end(), 0);
+                current_mark = 1;
+            }
+            queue.clear();
+        }
+
+        bool IsReached(VertexId vertex) const {
+            return marks[vertex] == current_mark;
+        }
+
+        // Возвращает true, если вес вершины улучшился
+        bool Relax(VertexId vertex, Weight weight, EdgeId prev_edge) {
+            if (IsReached(vertex) && !(weight < weights[vertex])) {
+                return false;
+            }
+            marks[vertex] = current_mark;
+            weights[vertex] = weight;
+            prev_edges[vertex] = prev_edge;
+            queue.emplace_back(weight, vertex);
+            std::push_heap(queue.begin(), queue.end(), std::greater<std::pair<Weight, VertexId>>{});
+            return true;
+        }
+
+        std::pair<Weight, VertexId> Pop() {
+            std::pop_heap(queue.begin(), queue.end(), std::greater<std::pair<Weight, VertexId>>{});
+            const auto top = queue.back();
+            queue.pop_back();
+            return top;
+        }
+    };
+
+    struct SearchState {
+        SearchSide forward;
+        SearchSide backward;
+    };
+
+    static SearchSide& GetWitnessSearch() {
+        static thread_local SearchSide side;
+        return side;
+    }
+
+    static SearchState& GetSearchState() {
+        static thread_local SearchState state;
+        return state;
+    }
+
+    EdgeId AddHierarchyEdge(const HierarchyEdge& edge);
+    void Contract(const Graph& graph);
+    size_t ContractVertex(VertexId vertex, bool simulate);
+    void RunWitnessSearch(VertexId source, VertexId excluded, Weight max_weight, size_t target_count,
+                          size_t settle_limit) const;
+    void BuildSearchGraphs(size_t vertex_count);
+    void UnpackEdge(EdgeId edge_id, std::vector<EdgeId>& edges) const;
+
+    std::vector<HierarchyEdge> edges_;
+    std::vector<size_t> ranks_;
+    size_t shortcut_count_ = 0;
+
+    // Рабочий граф на время сжатия
+    std::vector<std::vector<Arc>> out_arcs_;
+    std::vector<std::vector<Arc>> in_arcs_;
+    std::vector<size_t> contracted_neighbors_;
+    // Отметки целей поиска свидетеля: цель активна, если метка равна witness_mark_
+    std::vector<uint32_t> witness_targets_;
+    uint32_t witness_mark_ = 0;
+
+    // Графы поиска в формате CSR: рёбра вверх из вершины для прямого поиска
+    // и рёбра, входящие в вершину сверху, для обратного
+    std::vector<size_t> up_offsets_;
+    std::vector<Arc> up_arcs_;
+    std::vector<size_t> down_offsets_;
+    std::vector<Arc> down_arcs_;
+};
+
+template <typename Weight>
+ContractionHierarchyRouter<Weight>::ContractionHierarchyRouter(const Graph& graph) {
+    const size_t vertex_count = graph.GetVertexCount();
+    out_arcs_.resize(vertex_count);
+    in_arcs_.resize(vertex_count);
+    contracted_neighbors_.assign(vertex_count, 0);
+    witness_targets_.assign(vertex_count, 0);
+    ranks_.assign(vertex_count, 0);
+
+    // Из параллельных рёбер оставляем самое лёгкое (при равенстве — первое),
+    // петли в кратчайших путях не участвуют
+    for (VertexId vertex = 0; vertex < vertex_count; ++vertex) {
+        graph.ForEachIncidentEdge(vertex, [&](EdgeId edge_id, VertexId edge_to, Weight edge_weight) {
+            if (edge_weight < ZERO_WEIGHT) {
+                throw std::domain_error("Edges' weights should be non-negative");
+            }
+            if (edge_to == vertex) {
+                return;
+            }
+            auto& arcs = out_arcs_[vertex];
+            auto it = std::find_if(arcs.begin(), arcs.end(), [edge_to](const Arc& arc) {
+                return arc.neighbor == edge_to;
+            });
+            if (it == arcs.end()) {
+                AddHierarchyEdge({vertex, edge_to, edge_weight, edge_id});
+            } else if (edge_weight < edges_[it->edge].weight) {
+                edges_[it->edge].weight = edge_weight;
+                edges_[it->edge].original = edge_id;
+            }
+        });
+    }
+
+    Contract(graph);
+    BuildSearchGraphs(vertex_count);
+
+    out_arcs_ = {};
+    in_arcs_ = {};
+    contracted_neighbors_ = {};
+    witness_targets_ = {};
+}
+
+template <typename Weight>
+EdgeId ContractionHierarchyRouter<Weight>::AddHierarchyEdge(const HierarchyEdge& edge) {
+    edges_.push_back(edge);
+    const EdgeId id = edges_.size() - 1;
+    out_arcs_[edge.from].push_back({edge.to, id});
+    in_arcs_[edge.to].push_back({edge.from, id});
+    return id;
+}
+
+template <typename Weight>
+void ContractionHierarchyRouter<Weight>::Contract(const Graph& graph) {
+    const size_t vertex_count = graph.GetVertexCount();
+
+    // Приоритет вершины: разность рёбер (шорткаты минус удаляемые рёбра)
+    // плюс число уже сжатых соседей — так сжатие идёт равномерно по графу
+    const auto priority = [this](VertexId vertex) {
+        const size_t shortcuts = ContractVertex(vertex, true);
+        const auto removed = static_cast<long long>(out_arcs_[vertex].size() + in_arcs_[vertex].size());
+        return static_cast<long long>(shortcuts) - removed + static_cast<long long>(contracted_neighbors_[vertex]);
+    };
+
+    using QueueItem = std::pair<long long, VertexId>;
+    std::priority_queue<QueueItem, std::vector<QueueItem>, std::greater<QueueItem>> queue;
+    for (VertexId vertex = 0; vertex < vertex_count; ++vertex) {
+        queue.emplace(priority(vertex), vertex);
+    }
+
+    size_t rank = 0;
+    while (!queue.empty()) {
+        const auto [old_priority, vertex] = queue.top();
+        queue.pop();
+        // Ленивое обновление: если приоритет вырос и вершина больше не
+        // минимальна, откладываем её
+        const long long current_priority = priority(vertex);
+        if (!queue.empty() && current_priority > queue.top().first) {
+            queue.emplace(current_priority, vertex);
+            continue;
+        }
+        ContractVertex(vertex, false);
+        ranks_[vertex] = rank++;
+        // Удаляем сжатую вершину из списков соседей, чтобы поиски свидетелей
+        // не просматривали мёртвые рёбра
+        const auto points_to_vertex = [vertex = vertex](const Arc& arc) {
+            return arc.neighbor == vertex;
+        };
+        for (const Arc& arc : out_arcs_[vertex]) {
+            auto& arcs = in_arcs_[arc.neighbor];
+            arcs.erase(std::remove_if(arcs.begin(), arcs.end(), points_to_vertex), arcs.end());
+            ++contracted_neighbors_[arc.neighbor];
+        }
+        for (const Arc& arc : in_arcs_[vertex]) {
+            auto& arcs = out_arcs_[arc.neighbor];
+            arcs.erase(std::remove_if(arcs.begin(), arcs.end(), points_to_vertex), arcs.end());
+            ++contracted_neighbors_[arc.neighbor];
+        }
+    }
+}
+
+template <typename Weight>
+size_t ContractionHierarchyRouter<Weight>::ContractVertex(VertexId vertex, bool simulate) {
+    const auto& in_arcs = in_arcs_[vertex];
+    const auto& out_arcs = out_arcs_[vertex];
+
+    if (out_arcs.empty()) {
+        return 0;
+    }
+    Weight max_out_weight = edges_[out_arcs.front().edge].weight;
+    if (++witness_mark_ == 0) {
+        std::fill(witness_targets_.begin(), witness_targets_.end(), 0);
+        witness_mark_ = 1;
+    }
+    // Свидетель для цели возможен, только если в неё можно войти в обход
+    // сжимаемой вершины; остальные цели поиск не ждёт
+    size_t witness_target_count = 0;
+    for (const Arc& arc : out_arcs) {
+        max_out_weight = std::max(max_out_weight, edges_[arc.edge].weight);
+        for (const Arc& target_in : in_arcs_[arc.neighbor]) {
+            if (target_in.neighbor != vertex) {
+                witness_targets_[arc.neighbor] = witness_mark_;
+                ++witness_target_count;
+                break;
+            }
+        }
+    }
+
+    size_t shortcut_count = 0;
+    const SearchSide& witness = GetWitnessSearch();
+    // Копия нужна: при добавлении шорткатов списки соседей могут меняться
+    const std::vector<Arc> in_copy = in_arcs;
+    const std::vector<Arc> out_copy = out_arcs;
+    for (const Arc& in_arc : in_copy) {
+        const VertexId source = in_arc.neighbor;
+        const Weight in_weight = edges_[in_arc.edge].weight;
+        if (witness_target_count > 0) {
+            RunWitnessSearch(source, vertex, in_weight + max_out_weight, witness_target_count,
+                             simulate ? SIMULATION_SETTLE_LIMIT : WITNESS_SETTLE_LIMIT);
+        }
+
+        for (const Arc& out_arc : out_copy) {
+            const VertexId target = out_arc.neighbor;
+            if (target == source) {
+                continue;
+            }
+            const Weight shortcut_weight = in_weight + edges_[out_arc.edge].weight;
+            if (witness_targets_[target] == witness_mark_ && witness.IsReached(target)
+                && !(shortcut_weight < witness.weights[target])) {
+                continue;
+            }
+            ++shortcut_count;
+            if (simulate) {
+                continue;
+            }
+            auto& source_arcs = out_arcs_[source];
+            auto it = std::find_if(source_arcs.begin(), source_arcs.end(), [target](const Arc& arc) {
+                return arc.neighbor == target;
+            });
+            if (it != source_arcs.end()) {
+                const EdgeId existing_id = it->edge;
+                if (!(shortcut_weight < edges_[existing_id].weight)) {
+                    continue;
+                }
+                // Более тяжёлое ребро убираем из рабочего графа, но не из edges_:
+                // на него могут ссылаться уже построенные шорткаты
+                edges_[existing_id].replaced = true;
+                edges_.push_back({source, target, shortcut_weight, NO_EDGE, in_arc.edge, out_arc.edge});
+                it->edge = edges_.size() - 1;
+                for (Arc& arc : in_arcs_[target]) {
+                    if (arc.edge == existing_id) {
+                        arc.edge = it->edge;
+                    }
+                }
+            } else {
+                AddHierarchyEdge({source, target, shortcut_weight, NO_EDGE, in_arc.edge, out_arc.edge});
+            }
+            ++shortcut_count_;
+        }
+    }
+    return shortcut_count;
+}
+
+template <typename Weight>
+void ContractionHierarchyRouter<Weight>::RunWitnessSearch(VertexId source, VertexId excluded,
+                                                          Weight max_weight, size_t target_count,
+                                                          size_t settle_limit) const {
+    SearchSide& side = GetWitnessSearch();
+    side.Prepare(out_arcs_.size());
+    side.Relax(source, ZERO_WEIGHT, NO_EDGE);
+
+    // Поиск останавливается, когда все цели получили окончательный вес,
+    // вес превысил самый дорогой возможный шорткат или исчерпан лимит
+    size_t settled = 0;
+    while (!side.queue.empty() && settled < settle_limit && target_count > 0) {
+        const auto [weight, vertex] = side.Pop();
+        if (side.weights[vertex] < weight) {
+            continue;
+        }
+        if (max_weight < weight) {
+            break;
+        }
+        ++settled;
+        if (witness_targets_[vertex] == witness_mark_) {
+            --target_count;
+        }
+        for (const Arc& arc : out_arcs_[vertex]) {
+            if (arc.neighbor != excluded) {
+                side.Relax(arc.neighbor, weight + edges_[arc.edge].weight, arc.edge);
+            }
+        }
+    }
+}
+
+template <typename Weight>
+void ContractionHierarchyRouter<Weight>::BuildSearchGraphs(size_t vertex_count) {
+    up_offsets_.assign(vertex_count + 1, 0);
+    down_offsets_.assign(vertex_count + 1, 0);
+    for (const auto& edge : edges_) {
+        if (edge.replaced) {
+            continue;
+        }
+        if (ranks_[edge.from] < ranks_[edge.to]) {
+            ++up_offsets_[edge.from + 1];
+        } else {
+            ++down_offsets_[edge.to + 1];
+        }
+    }
+    for (size_t i = 0; i < vertex_count; ++i) {
+        up_offsets_[i + 1] += up_offsets_[i];
+        down_offsets_[i + 1] += down_offsets_[i];
+    }
+    up_arcs_.resize(up_offsets_.back());
+    down_arcs_.resize(down_offsets_.back());
+    std::vector<size_t> up_fill(up_offsets_.begin(), up_offsets_.end() - 1);
+    std::vector<size_t> down_fill(down_offsets_.begin(), down_offsets_.end() - 1);
+    for (EdgeId id = 0; id < edges_.size(); ++id) {
+        const auto& edge = edges_[id];
+        if (edge.replaced) {
+            continue;
+        }
+        if (ranks_[edge.from] < ranks_[edge.to]) {
+            up_arcs_[up_fill[edge.from]++] = {edge.to, id};
+        } else {
+            down_arcs_[down_fill[edge.to]++] = {edge.from, id};
+        }
+    }
+}
+
+template <typename Weight>
+std::optional<typename ContractionHierarchyRouter<Weight>::RouteInfo>
+    ContractionHierarchyRouter<Weight>::BuildRoute(VertexId from, VertexId to) const {
+    const size_t vertex_count = ranks_.size();
+    if (from >= vertex_count || to >= vertex_count) {
+        throw std::out_of_range("Vertex id is out of range");
+    }
+    if (from == to) {
+        return RouteInfo{ZERO_WEIGHT, {}};
+    }
+
+    SearchState& state = GetSearchState();
+    SearchSide& forward = state.forward;
+    SearchSide& backward = state.backward;
+    forward.Prepare(vertex_count);
+    backward.Prepare(vertex_count);
+    forward.Relax(from, ZERO_WEIGHT, NO_EDGE);
+    backward.Relax(to, ZERO_WEIGHT, NO_EDGE);
+
+    std::optional<Weight> best;
+    VertexId meeting = NO_VERTEX;
+
+    // Шаг поиска в одном направлении. Вершина «застревает» (stall-on-demand),
+    // если до неё можно дойти дешевле через более высокую вершину: такие
+    // вершины не лежат на кратчайшем пути иерархии и не раскрываются.
+    const auto step = [&](SearchSide& side, const SearchSide& other,
+                          const std::vector<size_t>& offsets, const std::vector<Arc>& arcs,
+                          const std::vector<size_t>& stall_offsets, const std::vector<Arc>& stall_arcs) {
+        const auto [weight, vertex] = side.Pop();
+        if (side.weights[vertex] < weight) {
+            return;
+        }
+        if (other.IsReached(vertex)) {
+            const Weight candidate = weight + other.weights[vertex];
+            if (!best || candidate < *best) {
+                best = candidate;
+                meeting = vertex;
+            }
+        }
+        for (size_t i = stall_offsets[vertex]; i < stall_offsets[vertex + 1]; ++i) {
+            const Arc& arc = stall_arcs[i];
+            if (side.IsReached(arc.neighbor) && side.weights[arc.neighbor] + edges_[arc.edge].weight < weight) {
+                return;
+            }
+        }
+        for (size_t i = offsets[vertex]; i < offsets[vertex + 1]; ++i) {
+            const Arc& arc = arcs[i];
+            side.Relax(arc.neighbor, weight + edges_[arc.edge].weight, arc.edge);
+        }
+    };
+
+    // Направление прекращает работу, когда его минимальный ключ не меньше
+    // лучшего найденного пути
+    const auto is_active = [&best](const SearchSide& side) {
+        return !side.queue.empty() && (!best || side.queue.front().first < *best);
+    };
+    bool forward_turn = true;
+    while (is_active(forward) || is_active(backward)) {
+        if ((forward_turn && is_active(forward)) || !is_active(backward)) {
+            step(forward, backward, up_offsets_, up_arcs_, down_offsets_, down_arcs_);
+        } else {
+            step(backward, forward, down_offsets_, down_arcs_, up_offsets_, up_arcs_);
+        }
+        forward_turn = !forward_turn;
+    }
+
+    if (!best) {
+        return std::nullopt;
+    }
+
+    std::vector<EdgeId> hierarchy_path;
+    for (EdgeId edge_id = forward.prev_edges[meeting]; edge_id != NO_EDGE;
+         edge_id = forward.prev_edges[edges_[edge_id].from]) {
+        hierarchy_path.push_back(edge_id);
+    }
+    std::reverse(hierarchy_path.begin(), hierarchy_path.end());
+    for (EdgeId edge_id = backward.prev_edges[meeting]; edge_id != NO_EDGE;
+         edge_id = backward.prev_edges[edges_[edge_id].to]) {
+        hierarchy_path.push_back(edge_id);
+    }
+
+    std::vector<EdgeId> edges;
+    for (const EdgeId edge_id : hierarchy_path) {
+        UnpackEdge(edge_id, edges);
+    }
+    return RouteInfo{*best, std::move(edges)};
+}
+
+template <typename Weight>
+void ContractionHierarchyRouter<Weight>::UnpackEdge(EdgeId edge_id, std::vector<EdgeId>& edges) const {
+    std::vector<EdgeId> stack{edge_id};
+    while (!stack.empty()) {
+        const auto& edge = edges_[stack.back()];
+        stack.pop_back();
+        if (edge.original != NO_EDGE) {
+            edges.push_back(edge.original);
+        } else {
+            stack.push_back(edge.second_half);
+            stack.push_back(edge.first_half);
+        }
+    }
+}
+
+}  // namespace graph
@@ -0,0 +1,231 @@
+#pragma once
+
+#include "graph.h"
+#include "route_engine.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace graph {
+
+// Маршрутизатор без предварительного расчёта: каждый запрос решается
+// одним запуском алгоритма Дейкстры из вершины from. Память и время
+// построения растут с числом рёбер, а не как V^2/V^3 у Router.
+template <typename Weight>
+class DijkstraRouter : public RouteEngine<Weight> {
+private:
+    using Graph = DirectedWeightedGraph<Weight>;
+
+public:
+    explicit DijkstraRouter(const Graph& graph);
+
+    using RouteInfo = graph::RouteInfo<Weight>;
+
+    std::optional<RouteInfo> BuildRoute(VertexId from, VertexId to) const override;
+    // Один поиск на все цели: останавливается, когда веса всех целей окончательны
+    std::vector<std::optional<RouteInfo>> BuildRoutes(VertexId from,
+                                                      const std::vector<VertexId>& targets) const override;
+
+    // Полный поиск из from: func(vertex, weight, prev_edge) вызывается для
+    // каждой достижимой вершины в порядке неубывания веса (для from —
+    // с весом ноль и без ребра)
+    template <typename Func>
+    void ForEachShortestPath(VertexId from, Func&& func) const;
+
+    SearchStats GetSearchStats() const override {
+        return counters_.Get();
+    }
+
+private:
+    // Рабочие буферы поиска. Живут в thread_local и переиспользуются между
+    // запросами: вместо очистки O(V) вершина считается посещённой в текущем
+    // поиске, только если её метка совпадает с current_mark.
+    struct SearchState {
+        std::vector<Weight> weights;
+        std::vector<EdgeId> prev_edges;
+        std::vector<uint32_t> marks;
+        std::vector<std::pair<Weight, VertexId>> queue;
+        std::vector<VertexId> settled;
+        std::vector<uint32_t> target_marks;
+        uint32_t current_mark = 0;
+
+        void Prepare(size_t vertex_count) {
+            if (marks.size() < vertex_count) {
+                weights.resize(vertex_count);
+                prev_edges.resize(vertex_count);
+                marks.resize(vertex_count, 0);
+                target_marks.resize(vertex_count, 0);
+            }
+            if (++current_mark == 0) {
+                std::fill(marks.begin(), marks.end(), 0);
+                std::fill(target_marks.begin(), target_marks.end(), 0);
+                current_mark = 1;
+            }
+            queue.clear();
+            settled.clear();
+        }
+
+        bool IsReached(VertexId vertex) const {
+            return marks[vertex] == current_mark;
+        }
+
+        void Reach(VertexId vertex, Weight weight, EdgeId prev_edge) {
+            marks[vertex] = current_mark;
+            weights[vertex] = weight;
+            prev_edges[vertex] = prev_edge;
+        }
+    };
+
+    static SearchState& GetSearchState() {
+        static thread_local SearchState state;
+        return state;
+    }
+
+    // Поиск из from; is_done(vertex) вызывается для каждой вершины с
+    // окончательным весом и может досрочно завершить поиск
+    template <typename IsDone>
+    void Search(SearchState& state, VertexId from, IsDone&& is_done) const;
+    RouteInfo ExtractRoute(const SearchState& state, VertexId to) const;
+    void CheckVertex(VertexId vertex) const;
+
+    static constexpr Weight ZERO_WEIGHT{};
+    static constexpr EdgeId NO_EDGE = static_cast<EdgeId>(-1);
+    const Graph& graph_;
+    SearchCounters counters_;
+};
+
+template <typename Weight>
+DijkstraRouter<Weight>::DijkstraRouter(const Graph& graph)
+    : graph_(graph)
+{
+    for (EdgeId edge_id = 0; edge_id < graph.GetEdgeCount(); ++edge_id) {
+        if (graph.GetEdge(edge_id).weight < ZERO_WEIGHT) {
+            throw std::domain_error("Edges' weights should be non-negative");
+        }
+    }
+}
+
+template <typename Weight>
+template <typename IsDone>
+void DijkstraRouter<Weight>::Search(SearchState& state, VertexId from, IsDone&& is_done) const {
+    auto& queue = state.queue;
+    const auto cmp = std::greater<std::pair<Weight, VertexId>>{};
+
+    state.Reach(from, ZERO_WEIGHT, NO_EDGE);
+    queue.emplace_back(ZERO_WEIGHT, from);
+    while (!queue.empty()) {
+        std::pop_heap(queue.begin(), queue.end(), cmp);
+        const auto [weight, vertex] = queue.back();
+        queue.pop_back();
+        // Устаревшая запись очереди: вершину уже достали с меньшим весом
+        if (state.weights[vertex] < weight) {
+            continue;
+        }
+        state.settled.push_back(vertex);
+        if (is_done(vertex)) {
+            break;
+        }
+        graph_.ForEachIncidentEdge(vertex, [&, weight = weight](EdgeId edge_id, VertexId edge_to, Weight edge_weight) {
+            const Weight candidate_weight = weight + edge_weight;
+            if (!state.IsReached(edge_to) || candidate_weight < state.weights[edge_to]) {
+                state.Reach(edge_to, candidate_weight, edge_id);
+                queue.emplace_back(candidate_weight, edge_to);
+                std::push_heap(queue.begin(), queue.end(), cmp);
+            }
+        });
+    }
+}
+
+template <typename Weight>
+typename DijkstraRouter<Weight>::RouteInfo DijkstraRouter<Weight>::ExtractRoute(const SearchState& state,
+                                                                                VertexId to) const {
+    std::vector<EdgeId> edges;
+    for (EdgeId edge_id = state.prev_edges[to]; edge_id != NO_EDGE;
+         edge_id = state.prev_edges[graph_.GetEdge(edge_id).from]) {
+        edges.push_back(edge_id);
+    }
+    std::reverse(edges.begin(), edges.end());
+    return RouteInfo{state.weights[to], std::move(edges)};
+}
+
+template <typename Weight>
+void DijkstraRouter<Weight>::CheckVertex(VertexId vertex) const {
+    if (vertex >= graph_.GetVertexCount()) {
+        throw std::out_of_range("Vertex id is out of range");
+    }
+}
+
+template <typename Weight>
+std::optional<typename DijkstraRouter<Weight>::RouteInfo> DijkstraRouter<Weight>::BuildRoute(VertexId from,
+                                                                                             VertexId to) const {
+    CheckVertex(from);
+    CheckVertex(to);
+
+    SearchState& state = GetSearchState();
+    state.Prepare(graph_.GetVertexCount());
+    Search(state, from, [to](VertexId vertex) {
+        return vertex == to;
+    });
+    counters_.Add(state.settled.size());
+    if (!state.IsReached(to)) {
+        return std::nullopt;
+    }
+    return ExtractRoute(state, to);
+}
+
+template <typename Weight>
+std::vector<std::optional<typename DijkstraRouter<Weight>::RouteInfo>> DijkstraRouter<Weight>::BuildRoutes(
+        VertexId from, const std::vector<VertexId>& targets) const {
+    CheckVertex(from);
+    if (targets.empty()) {
+        return {};
+    }
+    SearchState& state = GetSearchState();
+    state.Prepare(graph_.GetVertexCount());
+
+    // Цели помечаются текущей меткой, повторы считаются один раз
+    size_t remaining = 0;
+    for (const VertexId to : targets) {
+        CheckVertex(to);
+        if (state.target_marks[to] != state.current_mark) {
+            state.target_marks[to] = state.current_mark;
+            ++remaining;
+        }
+    }
+    Search(state, from, [&state, &remaining](VertexId vertex) {
+        return state.target_marks[vertex] == state.current_mark && --remaining == 0;
+    });
+    counters_.Add(state.settled.size());
+
+    std::vector<std::optional<RouteInfo>> routes;
+    routes.reserve(targets.size());
+    for (const VertexId to : targets) {
+        if (state.IsReached(to)) {
+            routes.push_back(ExtractRoute(state, to));
+        } else {
+            routes.push_back(std::nullopt);
+        }
+    }
+    return routes;
+}
+
+template <typename Weight>
+template <typename Func>
+void DijkstraRouter<Weight>::ForEachShortestPath(VertexId from, Func&& func) const {
+    CheckVertex(from);
+    SearchState& state = GetSearchState();
+    state.Prepare(graph_.GetVertexCount());
+    Search(state, from, [](VertexId) {
+        return false;
+    });
+    for (const VertexId vertex : state.settled) {
+        func(vertex, state.weights[vertex], state.prev_edges[vertex]);
+    }
+}
+
+}  // namespace graph
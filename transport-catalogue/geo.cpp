@@ -1,10 +1,23 @@
 #define _USE_MATH_DEFINES
 #include "geo.h"
 
+#include <algorithm>
 #include <cmath>
 
 namespace geo {
 
+namespace {
+
+constexpr double DEGREES_TO_RADIANS = M_PI / 180.0;
+
+// Длина дуги по квадрату хорды между единичными векторами. В отличие от
+// acos скалярного произведения, формула точна и для близких точек
+double ArcLength(double squared_chord) {
+    return 2.0 * std::asin(std::min(std::sqrt(squared_chord) * 0.5, 1.0)) * EARTH_RADIUS;
+}
+
+}  // namespace
+
 double ComputeDistance(Coordinates from, Coordinates to) {
     using namespace std;
     const double dr = M_PI / 180.0;
@@ -13,4 +26,56 @@ double ComputeDistance(Coordinates from, Coordinates to) {
         * 6371000;
 }
 
+UnitVector ToUnitVector(Coordinates coordinates) {
+    const double lat = coordinates.lat * DEGREES_TO_RADIANS;
+    const double lng = coordinates.lng * DEGREES_TO_RADIANS;
+    const double cos_lat = std::cos(lat);
+    return {cos_lat * std::cos(lng), cos_lat * std::sin(lng), std::sin(lat)};
+}
+
+double ComputeDistance(const UnitVector& from, const UnitVector& to) {
+    const double dx = from.x - to.x;
+    const double dy = from.y - to.y;
+    const double dz = from.z - to.z;
+    return ArcLength(dx * dx + dy * dy + dz * dz);
+}
+
+void UnitVectorPath::Clear() {
+    x_.clear();
+    y_.clear();
+    z_.clear();
+}
+
+void UnitVectorPath::Add(const UnitVector& point) {
+    x_.push_back(point.x);
+    y_.push_back(point.y);
+    z_.push_back(point.z);
+}
+
+double UnitVectorPath::ComputeLength() const {
+    const size_t count = GetSize();
+    if (count < 2) {
+        return 0.0;
+    }
+    // Сначала все квадраты хорд: цикл без ветвлений и вызовов
+    // векторизуется, затем asin по готовому массиву
+    static thread_local std::vector<double> squared_chords;
+    squared_chords.resize(count - 1);
+    const double* x = x_.data();
+    const double* y = y_.data();
+    const double* z = z_.data();
+    double* out = squared_chords.data();
+    for (size_t i = 0; i + 1 < count; ++i) {
+        const double dx = x[i] - x[i + 1];
+        const double dy = y[i] - y[i + 1];
+        const double dz = z[i] - z[i + 1];
+        out[i] = dx * dx + dy * dy + dz * dz;
+    }
+    double length = 0.0;
+    for (const double squared_chord : squared_chords) {
+        length += ArcLength(squared_chord);
+    }
+    return length;
+}
+
 }  // namespace geo
\ No newline at end of file
@@ -1,5 +1,8 @@
 #pragma once
 
+#include <cstddef>
+#include <vector>
+
 namespace geo {
 
 struct Coordinates {
@@ -7,6 +10,46 @@ struct Coordinates {
     double lng; // Долгота
 };
 
+// Средний радиус Земли в метрах
+inline constexpr double EARTH_RADIUS = 6371000;
+
 double ComputeDistance(const Coordinates from, const Coordinates to);
 
+// Точка на единичной сфере. Синусы и косинусы координат считаются один раз,
+// после чего расстояние между точками считается по длине хорды и asin.
+// Эта формула точна до 1e-8 м и на коротких отрезках, поэтому расхождение с
+// ComputeDistance по координатам — ошибка округления теоремы косинусов в
+// последней: не больше 1e-8 относительной для отрезков длиннее 1 км, 1 мм
+// для отрезков от 10 м до 1 км и 0.2 м для более коротких.
+struct UnitVector {
+    double x = 0.0;
+    double y = 0.0;
+    double z = 1.0;
+};
+
+UnitVector ToUnitVector(Coordinates coordinates);
+
+double ComputeDistance(const UnitVector& from, const UnitVector& to);
+
+// Последовательность точек, хранимая по координатам (x[], y[], z[]),
+// чтобы скалярные произведения соседних точек считались векторными
+// инструкциями
+class UnitVectorPath {
+public:
+    void Clear();
+    void Add(const UnitVector& point);
+
+    size_t GetSize() const {
+        return x_.size();
+    }
+
+    // Сумма расстояний между соседними точками
+    double ComputeLength() const;
+
+private:
+    std::vector<double> x_;
+    std::vector<double> y_;
+    std::vector<double> z_;
+};
+
 }  // namespace geo
\ No newline at end of file
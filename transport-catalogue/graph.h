@@ -2,7 +2,10 @@
 
 #include "ranges.h"
 
+#include <cstdint>
 #include <cstdlib>
+#include <memory>
+#include <stdexcept>
 #include <vector>
 
 namespace graph {
@@ -12,13 +15,21 @@ using EdgeId = size_t;
 
 template <typename Weight>
 struct Edge {
-    std::string name;
-    size_t span_count;
+    uint32_t name_id;     // Идентификатор названия (остановки или маршрута) у владельца графа
+    uint32_t span_count;
     VertexId from;
     VertexId to;
     Weight weight;
 };
 
+// Граф строится добавлением рёбер, после чего его можно «заморозить» (Freeze):
+// списки смежности упаковываются в формат CSR — смещения вершин и
+// непрерывные массивы концов и весов рёбер. Обход смежности тогда идёт
+// по памяти линейно, а полные записи рёбер (с названиями) остаются в
+// отдельном «холодном» массиве и нужны только для восстановления маршрута.
+// Замороженный граф можно перевзвесить (Reweighted): копия получает новые
+// веса за O(E) и разделяет с исходным графом индекс смежности и записи
+// рёбер, так что собственным у неё остаётся только массив весов.
 template <typename Weight>
 class DirectedWeightedGraph {
 private:
@@ -29,49 +40,203 @@ public:
     DirectedWeightedGraph() = default;
     explicit DirectedWeightedGraph(size_t vertex_count);
     EdgeId AddEdge(const Edge<Weight>& edge);
+    void Freeze();
+    // Граф с той же структурой и весами weight_of(edge); только для замороженного
+    template <typename WeightOf>
+    DirectedWeightedGraph Reweighted(WeightOf&& weight_of) const;
 
+    bool IsFrozen() const;
     size_t GetVertexCount() const;
     size_t GetEdgeCount() const;
-    const Edge<Weight>& GetEdge(EdgeId edge_id) const;
+    // Возвращает копию: у замороженного графа вес берётся из его массива весов
+    Edge<Weight> GetEdge(EdgeId edge_id) const;
     IncidentEdgesRange GetIncidentEdges(VertexId vertex) const;
 
+    // Обход исходящих рёбер вершины: func(edge_id, to, weight).
+    // Для замороженного графа читает только горячие массивы CSR.
+    template <typename Func>
+    void ForEachIncidentEdge(VertexId vertex, Func&& func) const;
+    // Обход входящих рёбер вершины: func(edge_id, from, weight).
+    // Только для замороженного графа.
+    template <typename Func>
+    void ForEachIncomingEdge(VertexId vertex, Func&& func) const;
+
 private:
+    // Заполняется в Freeze(): рёбра вершины v занимают позиции
+    // [offsets[v], offsets[v + 1]) в остальных массивах
+    struct Adjacency {
+        std::vector<size_t> offsets;
+        std::vector<EdgeId> edges;
+        std::vector<VertexId> targets;
+        // Обратный индекс: входящие рёбра вершин в том же формате;
+        // incoming_slots[i] — позиция того же ребра в прямом индексе
+        std::vector<size_t> incoming_offsets;
+        std::vector<EdgeId> incoming_edges;
+        std::vector<VertexId> incoming_sources;
+        std::vector<size_t> incoming_slots;
+        // Записи рёбер по номерам (поле weight не используется) и позиции
+        // рёбер в прямом индексе
+        std::vector<Edge<Weight>> records;
+        std::vector<size_t> edge_slots;
+    };
+
+    size_t vertex_count_ = 0;
     std::vector<Edge<Weight>> edges_;
     std::vector<IncidenceList> incidence_lists_;
+
+    // Общий для перевзвешенных копий индекс и собственные веса в порядке
+    // прямого индекса
+    std::shared_ptr<const Adjacency> adjacency_;
+    std::vector<Weight> weights_;
 };
 
 template <typename Weight>
 DirectedWeightedGraph<Weight>::DirectedWeightedGraph(size_t vertex_count)
-    : incidence_lists_(vertex_count) {
+    : vertex_count_(vertex_count)
+    , incidence_lists_(vertex_count) {
 }
 
 template <typename Weight>
 EdgeId DirectedWeightedGraph<Weight>::AddEdge(const Edge<Weight>& edge) {
+    if (adjacency_) {
+        throw std::logic_error("Cannot add edges to a frozen graph");
+    }
     edges_.push_back(edge);
     const EdgeId id = edges_.size() - 1;
     incidence_lists_.at(edge.from).push_back(id);
     return id;
 }
 
+template <typename Weight>
+void DirectedWeightedGraph<Weight>::Freeze() {
+    if (adjacency_) {
+        return;
+    }
+    auto adjacency = std::make_shared<Adjacency>();
+    adjacency->offsets.assign(vertex_count_ + 1, 0);
+    for (VertexId vertex = 0; vertex < vertex_count_; ++vertex) {
+        adjacency->offsets[vertex + 1] = adjacency->offsets[vertex] + incidence_lists_[vertex].size();
+    }
+    adjacency->edges.reserve(edges_.size());
+    adjacency->targets.reserve(edges_.size());
+    adjacency->edge_slots.resize(edges_.size());
+    weights_.reserve(edges_.size());
+    // Порядок рёбер внутри вершины сохраняется
+    for (const auto& incidence_list : incidence_lists_) {
+        for (const EdgeId edge_id : incidence_list) {
+            adjacency->edge_slots[edge_id] = adjacency->edges.size();
+            adjacency->edges.push_back(edge_id);
+            adjacency->targets.push_back(edges_[edge_id].to);
+            weights_.push_back(edges_[edge_id].weight);
+        }
+    }
+    incidence_lists_ = {};
+
+    // Входящие рёбра раскладываются подсчётом в порядке номеров рёбер
+    adjacency->incoming_offsets.assign(vertex_count_ + 1, 0);
+    for (const auto& edge : edges_) {
+        ++adjacency->incoming_offsets[edge.to + 1];
+    }
+    for (VertexId vertex = 0; vertex < vertex_count_; ++vertex) {
+        adjacency->incoming_offsets[vertex + 1] += adjacency->incoming_offsets[vertex];
+    }
+    adjacency->incoming_edges.resize(edges_.size());
+    adjacency->incoming_sources.resize(edges_.size());
+    adjacency->incoming_slots.resize(edges_.size());
+    std::vector<size_t> next_slots(adjacency->incoming_offsets.begin(), adjacency->incoming_offsets.end() - 1);
+    for (EdgeId edge_id = 0; edge_id < edges_.size(); ++edge_id) {
+        const size_t slot = next_slots[edges_[edge_id].to]++;
+        adjacency->incoming_edges[slot] = edge_id;
+        adjacency->incoming_sources[slot] = edges_[edge_id].from;
+        adjacency->incoming_slots[slot] = adjacency->edge_slots[edge_id];
+    }
+    adjacency->records = std::move(edges_);
+    edges_ = {};
+    adjacency_ = std::move(adjacency);
+}
+
+template <typename Weight>
+template <typename WeightOf>
+DirectedWeightedGraph<Weight> DirectedWeightedGraph<Weight>::Reweighted(WeightOf&& weight_of) const {
+    if (!adjacency_) {
+        throw std::logic_error("Only a frozen graph can be reweighted");
+    }
+    DirectedWeightedGraph result;
+    result.vertex_count_ = vertex_count_;
+    result.adjacency_ = adjacency_;
+    result.weights_.reserve(weights_.size());
+    for (const EdgeId edge_id : adjacency_->edges) {
+        result.weights_.push_back(weight_of(GetEdge(edge_id)));
+    }
+    return result;
+}
+
+template <typename Weight>
+bool DirectedWeightedGraph<Weight>::IsFrozen() const {
+    return adjacency_ != nullptr;
+}
+
 template <typename Weight>
 size_t DirectedWeightedGraph<Weight>::GetVertexCount() const {
-    return incidence_lists_.size();
+    return vertex_count_;
 }
 
 template <typename Weight>
 size_t DirectedWeightedGraph<Weight>::GetEdgeCount() const {
-    return edges_.size();
+    return adjacency_ ? adjacency_->records.size() : edges_.size();
 }
 
 template <typename Weight>
-const Edge<Weight>& DirectedWeightedGraph<Weight>::GetEdge(EdgeId edge_id) const {
+Edge<Weight> DirectedWeightedGraph<Weight>::GetEdge(EdgeId edge_id) const {
+    if (adjacency_) {
+        Edge<Weight> edge = adjacency_->records.at(edge_id);
+        edge.weight = weights_[adjacency_->edge_slots[edge_id]];
+        return edge;
+    }
     return edges_.at(edge_id);
 }
 
 template <typename Weight>
 typename DirectedWeightedGraph<Weight>::IncidentEdgesRange
     DirectedWeightedGraph<Weight>::GetIncidentEdges(VertexId vertex) const {
+    if (adjacency_) {
+        if (vertex >= vertex_count_) {
+            throw std::out_of_range("Vertex id is out of range");
+        }
+        return IncidentEdgesRange{adjacency_->edges.begin() + adjacency_->offsets[vertex],
+                                  adjacency_->edges.begin() + adjacency_->offsets[vertex + 1]};
+    }
     return ranges::AsRange(incidence_lists_.at(vertex));
 }
 
+template <typename Weight>
+template <typename Func>
+void DirectedWeightedGraph<Weight>::ForEachIncidentEdge(VertexId vertex, Func&& func) const {
+    if (adjacency_) {
+        const Adjacency& adjacency = *adjacency_;
+        const size_t end = adjacency.offsets[vertex + 1];
+        for (size_t i = adjacency.offsets[vertex]; i < end; ++i) {
+            func(adjacency.edges[i], adjacency.targets[i], weights_[i]);
+        }
+        return;
+    }
+    for (const EdgeId edge_id : incidence_lists_[vertex]) {
+        const auto& edge = edges_[edge_id];
+        func(edge_id, edge.to, edge.weight);
+    }
+}
+
+template <typename Weight>
+template <typename Func>
+void DirectedWeightedGraph<Weight>::ForEachIncomingEdge(VertexId vertex, Func&& func) const {
+    if (!adjacency_) {
+        throw std::logic_error("Incoming edges are available only in a frozen graph");
+    }
+    const Adjacency& adjacency = *adjacency_;
+    const size_t end = adjacency.incoming_offsets[vertex + 1];
+    for (size_t i = adjacency.incoming_offsets[vertex]; i < end; ++i) {
+        func(adjacency.incoming_edges[i], adjacency.incoming_sources[i], weights_[adjacency.incoming_slots[i]]);
+    }
+}
+
 } // namespace graph
\ No newline at end of file
@@ -2,13 +2,28 @@
 #include "transport_router.h"
 #include "domain.h"
 #include "json_builder.h"
+#include "parallel.h"
+#include "router_storage.h"
 #include <iostream>
 #include <algorithm>
 #include <set>
+#include <unordered_map>
 #include <iomanip> // Для std::setprecision
 
 namespace json_reader {
 
+namespace {
+
+// Хеш текстового представления узла: Dict упорядочен, поэтому одинаковые
+// данные дают одинаковый текст
+uint64_t HashNode(const json::Node& node, uint64_t hash) {
+    std::ostringstream output;
+    json::Print(node, output, 0);
+    return transport::HashBytes(output.str(), hash);
+}
+
+}  // namespace
+
 JsonReader::JsonReader(transport_catalogue::TransportCatalogue& catalogue) : catalogue_(catalogue) {}
 
 void JsonReader::LoadData(const json::Node& data) {
@@ -24,6 +39,7 @@ void JsonReader::LoadData(const json::Node& data) {
     }
 
     const auto& base_requests = data.AsMap().at("base_requests").AsArray();
+    base_requests_hash_ = HashNode(data.AsMap().at("base_requests"), transport::HashBytes({}));
 
     // Первый проход: добавляем только остановки (Stop)
     for (size_t i = 0; i < base_requests.size(); ++i) {
@@ -65,7 +81,12 @@ void JsonReader::LoadData(const json::Node& data) {
         }
     }
 
-    
+    // Дальше каталог только читается
+    catalogue_.Freeze();
+    // Статистика маршрутов считается один раз для всех запросов "Bus"
+    catalogue_.PrepareBusInfos();
+    // Индекс для запросов "NearbyStops" и "StopsInArea"
+    catalogue_.PrepareStopIndex();
 }
 
 void JsonReader::ProcessStopRequest(const json::Dict& request_map) {
@@ -80,7 +101,7 @@ void JsonReader::ProcessStopRequest(const json::Dict& request_map) {
     std::string stop_name = request_map.at("name").AsString();
     double lat = request_map.at("latitude").AsDouble();
     double lng = request_map.at("longitude").AsDouble();
-    catalogue_.AddStop(stop_name, {lat, lng});
+    const auto from_stop_id = catalogue_.AddStop(stop_name, {lat, lng});
 
     const auto& road_distances = request_map.at("road_distances").AsMap();
     for (const auto& [neighbor_stop_name, distance] : road_distances) {
@@ -90,20 +111,10 @@ void JsonReader::ProcessStopRequest(const json::Dict& request_map) {
         }
 
         int dist = distance.AsInt();
-        const auto* from_stop = catalogue_.FindStop(stop_name);
-        const auto* to_stop = catalogue_.FindStop(neighbor_stop_name);
-
         // Если вторая остановка не найдена, добавляем её с нулевыми координатами
-        if (to_stop == nullptr) {
-            catalogue_.AddStop(neighbor_stop_name, {0.0, 0.0});
-            to_stop = catalogue_.FindStop(neighbor_stop_name);
-        }
-
-        if (from_stop && to_stop) {
-            catalogue_.SetDistance(from_stop, to_stop, dist);
-        } else {
-            std::cerr << "Error: One or both stops not found\n";
-        }
+        const auto* to_stop = catalogue_.FindStop(neighbor_stop_name);
+        const auto to_stop_id = to_stop ? to_stop->id : catalogue_.AddStop(neighbor_stop_name, {0.0, 0.0});
+        catalogue_.SetDistance(from_stop_id, to_stop_id, dist);
     }
 }
 
@@ -119,7 +130,7 @@ void JsonReader::ProcessBusRequest(const json::Dict& request_map) {
     bool is_roundtrip = request_map.at("is_roundtrip").AsBool();
     const auto& stops_array = request_map.at("stops").AsArray();
 
-    std::vector<const transport_catalogue::Stop*> stops;
+    std::vector<transport_catalogue::StopId> stops;
     for (size_t j = 0; j < stops_array.size(); ++j) {
         if (!stops_array[j].IsString()) {
             std::cerr << "Error: Stop name is not a string\n";
@@ -128,7 +139,7 @@ void JsonReader::ProcessBusRequest(const json::Dict& request_map) {
 
         const auto* stop = catalogue_.FindStop(stops_array[j].AsString());
         if (stop) {
-            stops.push_back(stop);
+            stops.push_back(stop->id);
         } else {
             std::cerr << "Error: Stop not found: " << stops_array[j].AsString() << "\n";
         }
@@ -147,8 +158,11 @@ json::Node JsonReader::ProcessRequests(const json::Node& requests, const json::N
     }
 
     const auto& requests_array = requests.AsArray();
+    // Маршруты считаются заранее, пакетами по остановке отправления
+    const auto routes = ComputeRoutes(requests_array);
 
-    // Обрабатываем запросы "Stop", "Bus", "Map" и "Route"
+    // Обрабатываем запросы "Stop", "Bus", "Map", "Route", "NearbyStops",
+    // "StopsInArea" и отладочный "RouterStats"
     for (size_t i = 0; i < requests_array.size(); ++i) {
         const auto& request = requests_array[i];
         if (!request.IsMap()) {
@@ -172,7 +186,13 @@ json::Node JsonReader::ProcessRequests(const json::Node& requests, const json::N
         } else if (type == "Map") {
             ProcessMapResponse(builder, id, render_settings);
         } else if (type == "Route") {
-            ProcessRouteResponse(builder, request_map, id);
+            ProcessRouteResponse(builder, request_map, id, routes[i]);
+        } else if (type == "NearbyStops") {
+            ProcessNearbyStopsResponse(builder, request_map, id);
+        } else if (type == "StopsInArea") {
+            ProcessStopsInAreaResponse(builder, request_map, id);
+        } else if (type == "RouterStats") {
+            ProcessRouterStatsResponse(builder, id);
         }
     }
 
@@ -190,18 +210,18 @@ void JsonReader::ProcessStopResponse(json::Builder& builder, const json::Dict& r
             .Key("error_message").Value("not found")
             .EndDict();
     } else {
-        const auto& buses = catalogue_.GetBusesByStop(stop_name);
-        std::set<std::string> bus_names; // Используем set для автоматической сортировки
+        const auto& buses = catalogue_.GetBusesByStop(stop->id);
+        std::set<std::string_view> bus_names; // Используем set для автоматической сортировки
 
-        for (const transport_catalogue::Bus* bus : buses) {
-            bus_names.insert(bus->name); // Добавляем имена автобусов в set
+        for (const auto bus_id : buses) {
+            bus_names.insert(catalogue_.GetBusById(bus_id).name); // Добавляем имена автобусов в set
         }
 
         builder.StartDict()
             .Key("request_id").Value(id)
             .Key("buses").StartArray();
-        for (const std::string& name : bus_names) {
-            builder.Value(name);
+        for (const std::string_view name : bus_names) {
+            builder.Value(std::string(name));
         }
         builder.EndArray().EndDict();
     }
@@ -229,6 +249,54 @@ void JsonReader::ProcessBusResponse(json::Builder& builder, const json::Dict& re
     }
 }
 
+void JsonReader::ProcessNearbyStopsResponse(json::Builder& builder, const json::Dict& request_map, int id) {
+    const double lat = request_map.at("latitude").AsDouble();
+    const double lng = request_map.at("longitude").AsDouble();
+    const int count = request_map.at("count").AsInt();
+    if (count < 0) {
+        builder.StartDict()
+            .Key("request_id").Value(id)
+            .Key("error_message").Value("invalid count")
+            .EndDict();
+        return;
+    }
+
+    builder.StartDict()
+        .Key("request_id").Value(id)
+        .Key("stops").StartArray();
+    for (const auto& nearby_stop : catalogue_.FindNearestStops({lat, lng}, static_cast<size_t>(count))) {
+        builder.StartDict()
+            .Key("name").Value(std::string(catalogue_.GetStopById(nearby_stop.id).name))
+            .Key("distance").Value(nearby_stop.distance)
+            .EndDict();
+    }
+    builder.EndArray().EndDict();
+}
+
+void JsonReader::ProcessStopsInAreaResponse(json::Builder& builder, const json::Dict& request_map, int id) {
+    const geo::Coordinates min{request_map.at("min_latitude").AsDouble(), request_map.at("min_longitude").AsDouble()};
+    const geo::Coordinates max{request_map.at("max_latitude").AsDouble(), request_map.at("max_longitude").AsDouble()};
+    if (min.lat > max.lat || min.lng > max.lng) {
+        builder.StartDict()
+            .Key("request_id").Value(id)
+            .Key("error_message").Value("invalid area")
+            .EndDict();
+        return;
+    }
+
+    std::set<std::string_view> stop_names; // Названия по алфавиту, как маршруты в ответе "Stop"
+    for (const auto stop_id : catalogue_.FindStopsInArea(min, max)) {
+        stop_names.insert(catalogue_.GetStopById(stop_id).name);
+    }
+    builder.StartDict()
+        .Key("request_id").Value(id)
+        .Key("stops").StartArray();
+    for (const std::string_view name : stop_names) {
+        builder.Value(std::string(name));
+    }
+    builder.EndArray().EndDict();
+}
+
 void JsonReader::ProcessMapResponse(json::Builder& builder, int id, const json::Node& render_settings) {
     // Генерация SVG-изображения
     std::ostringstream svg_stream;
@@ -243,6 +311,26 @@ void JsonReader::ProcessMapResponse(json::Builder& builder, int id, const json::
         .EndDict();
 }
 
+// Счётчики кэша ответов и поиска движков роутера. Маршруты пакета
+// считаются до разбора ответов, поэтому счётчики включают все запросы
+// "Route" пакета
+void JsonReader::ProcessRouterStatsResponse(json::Builder& builder, int id) {
+    const cache::CacheStats cache_stats = cached_router_ ? cached_router_->GetCacheStats() : cache::CacheStats{};
+    const graph::SearchStats search_stats = cached_router_ ? cached_router_->GetSearchStats() : graph::SearchStats{};
+    builder.StartDict()
+        .Key("request_id").Value(id)
+        .Key("cache").StartDict()
+            .Key("hits").Value(static_cast<int>(cache_stats.hits))
+            .Key("misses").Value(static_cast<int>(cache_stats.misses))
+            .Key("size").Value(static_cast<int>(cache_stats.size))
+        .EndDict()
+        .Key("search").StartDict()
+            .Key("queries").Value(static_cast<int>(search_stats.queries))
+            .Key("settled_vertices").Value(static_cast<int>(search_stats.settled_vertices))
+        .EndDict()
+        .EndDict();
+}
+
 StatReader::StatReader(const transport_catalogue::TransportCatalogue& catalogue) : catalogue_(catalogue) {}
 
 void StatReader::ProcessQuery(const json::Node& query) const {
@@ -301,12 +389,12 @@ void StatReader::ProcessStopQuery(json::Builder& builder, const json::Dict& quer
             .Key("error_message").Value("not found")
             .EndDict();
     } else {
-        const auto& buses = catalogue_.GetBusesByStop(stop_name);
+        const auto& buses = catalogue_.GetBusesByStop(stop->id);
         builder.StartDict()
             .Key("request_id").Value(request_id)
             .Key("buses").StartArray();
-        for (const transport_catalogue::Bus* bus : buses) {
-            builder.Value(bus->name);
+        for (const auto bus_id : buses) {
+            builder.Value(std::string(catalogue_.GetBusById(bus_id).name));
         }
         builder.EndArray().EndDict();
     }
@@ -319,11 +407,102 @@ void StatReader::ProcessMapQuery(json::Builder& builder, int request_id) const {
         .EndDict();
 }
 
-void JsonReader::ProcessRouteResponse(json::Builder& builder, const json::Dict& request_map, int id) {
-    std::string stop_from = request_map.at("from").AsString();
-    std::string stop_to = request_map.at("to").AsString();
+const transport::Router& JsonReader::GetRouter() {
+    // Роутер строится при первом вызове и перестраивается (вместе с кэшем
+    // ответов), если с тех пор изменились данные каталога
+    if (!cached_router_ || cached_router_->GetCatalogueVersion() != catalogue_.GetVersion()) {
+        transport::RouterSettings settings;
+        settings.bus_wait_time = catalogue_.GetRoutingSettings().bus_wait_time;
+        settings.bus_velocity = catalogue_.GetRoutingSettings().bus_velocity;
+        settings.engine = router_engine_;
+        settings.graph_model = graph_model_;
+        if (route_cache_size_) {
+            settings.route_cache_size = *route_cache_size_;
+        }
+        settings.fewest_transfers = fewest_transfers_;
+        settings.walk_radius = walk_radius_;
+        if (walk_velocity_) {
+            settings.walk_velocity = *walk_velocity_;
+        }
+        settings.state_file = state_file_;
+        settings.state_key = state_key_;
+        cached_router_ = std::make_unique<transport::Router>(settings, catalogue_);
+    }
+
+    // Изменённые параметры профилей только перевзвешивают общий граф
+    const auto sync_profile = [this](const std::string& name, const transport::RoutingProfile& profile) {
+        const auto current = cached_router_->GetProfile(name);
+        if (!current || current->bus_wait_time != profile.bus_wait_time
+            || current->bus_velocity != profile.bus_velocity) {
+            cached_router_->SetProfile(name, profile);
+        }
+    };
+    sync_profile({}, {catalogue_.GetRoutingSettings().bus_wait_time, catalogue_.GetRoutingSettings().bus_velocity});
+    for (const auto& [name, profile] : routing_profiles_) {
+        sync_profile(name, profile);
+    }
+    return *cached_router_;
+}
+
+std::vector<std::optional<transport::RouteInfo>> JsonReader::ComputeRoutes(const json::Array& requests) {
+    std::vector<std::optional<transport::RouteInfo>> routes(requests.size());
+
+    // Запросы "Route" группируются по профилю и остановке отправления в
+    // порядке первого появления; маршрут из остановки в неё же строить не
+    // нужно. Названия остановок переводятся в номера здесь, дальше роутер
+    // работает только с номерами; для неизвестной остановки маршрута нет.
+    struct SourceGroup {
+        std::string_view profile;
+        transport_catalogue::StopId stop_from;
+        std::vector<transport_catalogue::StopId> stops_to;
+        std::vector<size_t> request_indices;
+    };
+    std::vector<SourceGroup> groups;
+    std::map<std::pair<std::string_view, transport_catalogue::StopId>, size_t> group_by_source;
+    for (size_t i = 0; i < requests.size(); ++i) {
+        if (!requests[i].IsMap()) {
+            continue;
+        }
+        const auto& request_map = requests[i].AsMap();
+        const auto type_it = request_map.find("type");
+        if (type_it == request_map.end() || type_it->second.AsString() != "Route") {
+            continue;
+        }
+        const auto* stop_from = catalogue_.FindStop(request_map.at("from").AsString());
+        const auto* stop_to = catalogue_.FindStop(request_map.at("to").AsString());
+        if (!stop_from || !stop_to || stop_from == stop_to) {
+            continue;
+        }
+        const auto profile_it = request_map.find("profile");
+        const std::string_view profile = profile_it != request_map.end() && profile_it->second.IsString()
+            ? std::string_view(profile_it->second.AsString()) : std::string_view{};
+        const auto [it, inserted] = group_by_source.emplace(std::pair{profile, stop_from->id}, groups.size());
+        if (inserted) {
+            groups.push_back({profile, stop_from->id, {}, {}});
+        }
+        groups[it->second].stops_to.push_back(stop_to->id);
+        groups[it->second].request_indices.push_back(i);
+    }
+    if (groups.empty()) {
+        return routes;
+    }
+
+    // Каждая группа — одно построение дерева кратчайших путей; группы
+    // независимы и пишут в разные элементы routes
+    const transport::Router& router = GetRouter();
+    parallel::ParallelFor(groups.size(), [&](size_t group_index) {
+        const SourceGroup& group = groups[group_index];
+        auto group_routes = router.GetRouteInfos(group.stop_from, group.stops_to, group.profile);
+        for (size_t k = 0; k < group_routes.size(); ++k) {
+            routes[group.request_indices[k]] = std::move(group_routes[k]);
+        }
+    });
+    return routes;
+}
 
-    if (stop_from == stop_to) {
+void JsonReader::ProcessRouteResponse(json::Builder& builder, const json::Dict& request_map, int id,
+                                      const std::optional<transport::RouteInfo>& route_info) {
+    if (request_map.at("from").AsString() == request_map.at("to").AsString()) {
         builder.StartDict()
             .Key("request_id").Value(id)
             .Key("total_time").Value(0)
@@ -332,17 +511,6 @@ void JsonReader::ProcessRouteResponse(json::Builder& builder, const json::Dict&
         return;
     }
 
-    // Инициализация роутера при первом вызове
-    if (!cached_router_) {
-        transport::RouterSettings settings{
-            catalogue_.GetRoutingSettings().bus_wait_time,
-            catalogue_.GetRoutingSettings().bus_velocity
-        };
-        cached_router_ = std::make_unique<transport::Router>(settings, catalogue_);
-    }
-
-    auto route_info = cached_router_->GetRouteInfo(stop_from, stop_to);
-
     if (!route_info) {
         builder.StartDict()
             .Key("request_id").Value(id)
@@ -359,14 +527,21 @@ void JsonReader::ProcessRouteResponse(json::Builder& builder, const json::Dict&
                 const auto& wait = std::get<transport::WaitItem>(item);
                 builder.StartDict()
                     .Key("type").Value("Wait")
-                    .Key("stop_name").Value(wait.stop_name)
+                    .Key("stop_name").Value(std::string(catalogue_.GetStopById(wait.stop_id).name))
                     .Key("time").Value(wait.time)
                     .EndDict();
+            } else if (std::holds_alternative<transport::WalkItem>(item)) {
+                const auto& walk = std::get<transport::WalkItem>(item);
+                builder.StartDict()
+                    .Key("type").Value("Walk")
+                    .Key("stop_name").Value(std::string(catalogue_.GetStopById(walk.stop_id).name))
+                    .Key("time").Value(walk.time)
+                    .EndDict();
             } else {
                 const auto& bus = std::get<transport::BusItem>(item);
                 builder.StartDict()
                     .Key("type").Value("Bus")
-                    .Key("bus").Value(bus.bus)
+                    .Key("bus").Value(std::string(catalogue_.GetBusById(bus.bus_id).name))
                     .Key("span_count").Value(static_cast<int>(bus.span_count))
                     .Key("time").Value(bus.time)
                     .EndDict();
@@ -395,6 +570,98 @@ void JsonReader::LoadRoutingSettings(const json::Node& settings_node) {
     settings.bus_wait_time = settings_map.at("bus_wait_time").AsInt();
     settings.bus_velocity = settings_map.at("bus_velocity").AsDouble();
 
+    // Необязательный выбор алгоритма маршрутизации
+    if (auto it = settings_map.find("router_engine"); it != settings_map.end()) {
+        const auto engine = it->second.IsString() ? transport::ParseRouterEngine(it->second.AsString()) : std::nullopt;
+        if (engine) {
+            router_engine_ = *engine;
+        } else {
+            std::cerr << "Error: unknown router_engine in routing_settings\n";
+        }
+    }
+
+    // Необязательная модель графа: пары остановок или цепочки маршрутов
+    if (auto it = settings_map.find("graph_model"); it != settings_map.end()) {
+        const auto model = it->second.IsString() ? transport::ParseGraphModel(it->second.AsString()) : std::nullopt;
+        if (model) {
+            graph_model_ = *model;
+        } else {
+            std::cerr << "Error: unknown graph_model in routing_settings\n";
+        }
+    }
+
+    // Необязательный размер кэша ответов на запросы маршрутов
+    if (auto it = settings_map.find("route_cache_size"); it != settings_map.end()) {
+        if (it->second.IsInt() && it->second.AsInt() >= 0) {
+            route_cache_size_ = static_cast<size_t>(it->second.AsInt());
+        } else {
+            std::cerr << "Error: route_cache_size in routing_settings should be a non-negative integer\n";
+        }
+    }
+
+    // Необязательный критерий: минимум пересадок (учитывается движком RAPTOR)
+    if (auto it = settings_map.find("fewest_transfers"); it != settings_map.end()) {
+        if (it->second.IsBool()) {
+            fewest_transfers_ = it->second.AsBool();
+        } else {
+            std::cerr << "Error: fewest_transfers in routing_settings should be a boolean\n";
+        }
+    }
+
+    // Необязательные пешие переходы между близкими остановками: радиус в
+    // метрах и скорость пешехода в км/ч
+    if (auto it = settings_map.find("walk_radius"); it != settings_map.end()) {
+        if (it->second.IsDouble() && it->second.AsDouble() >= 0.0) {
+            walk_radius_ = it->second.AsDouble();
+        } else {
+            std::cerr << "Error: walk_radius in routing_settings should be a non-negative number\n";
+        }
+    }
+    if (auto it = settings_map.find("walk_velocity"); it != settings_map.end()) {
+        if (it->second.IsDouble() && it->second.AsDouble() > 0.0) {
+            walk_velocity_ = it->second.AsDouble();
+        } else {
+            std::cerr << "Error: walk_velocity in routing_settings should be a positive number\n";
+        }
+    }
+
+    // Необязательный файл предрасчитанного состояния роутера; ключ файла —
+    // хеш исходных данных и настроек маршрутизации
+    if (auto it = settings_map.find("state_file"); it != settings_map.end()) {
+        if (it->second.IsString()) {
+            state_file_ = it->second.AsString();
+        } else {
+            std::cerr << "Error: state_file in routing_settings should be a string\n";
+        }
+    }
+
+    // Необязательные именованные профили: запрос "Route" выбирает профиль
+    // полем "profile", без него используется профиль по умолчанию
+    if (auto it = settings_map.find("profiles"); it != settings_map.end()) {
+        if (!it->second.IsArray()) {
+            std::cerr << "Error: profiles in routing_settings should be an array\n";
+        } else {
+            for (const auto& profile_node : it->second.AsArray()) {
+                if (!profile_node.IsMap()) {
+                    std::cerr << "Error: routing profile is not a map\n";
+                    continue;
+                }
+                const auto& profile_map = profile_node.AsMap();
+                if (profile_map.find("name") == profile_map.end()
+                    || profile_map.find("bus_wait_time") == profile_map.end()
+                    || profile_map.find("bus_velocity") == profile_map.end()) {
+                    std::cerr << "Error: missing required fields in routing profile\n";
+                    continue;
+                }
+                routing_profiles_[profile_map.at("name").AsString()] = {
+                    profile_map.at("bus_wait_time").AsInt(),
+                    profile_map.at("bus_velocity").AsDouble()
+                };
+            }
+        }
+    }
+    state_key_ = HashNode(settings_node, base_requests_hash_);
+
     catalogue_.SetRoutingSettings(settings);
 }
 
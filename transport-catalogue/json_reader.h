@@ -5,6 +5,7 @@
 #include "json.h"
 #include "json_builder.h"
 #include "transport_router.h"
+#include <map>
 #include <sstream>
 #include <string>
 #include <vector>
@@ -23,15 +24,32 @@ public:
 
 private:
     transport_catalogue::TransportCatalogue& catalogue_;
-    std::optional<graph::DirectedWeightedGraph<double>> cached_graph_;
     std::unique_ptr<transport::Router> cached_router_;
+    transport::RouterEngine router_engine_ = transport::RouterEngine::ALL_PAIRS;
+    transport::GraphModel graph_model_ = transport::GraphModel::STOP_PAIRS;
+    std::optional<size_t> route_cache_size_;
+    bool fewest_transfers_ = false;
+    double walk_radius_ = 0.0;
+    std::optional<double> walk_velocity_;
+    std::string state_file_;
+    // Именованные профили маршрутизации из routing_settings.profiles
+    std::map<std::string, transport::RoutingProfile> routing_profiles_;
+    uint64_t base_requests_hash_ = 0;
+    uint64_t state_key_ = 0;
 
     void ProcessStopRequest(const json::Dict& request_map);
     void ProcessBusRequest(const json::Dict& request_map);
     void ProcessStopResponse(json::Builder& builder, const json::Dict& request_map, int id);
     void ProcessBusResponse(json::Builder& builder, const json::Dict& request_map, int id);
     void ProcessMapResponse(json::Builder& builder, int id, const json::Node& render_settings);
-    void ProcessRouteResponse(json::Builder& builder, const json::Dict& request_map, int id);
+    void ProcessNearbyStopsResponse(json::Builder& builder, const json::Dict& request_map, int id);
+    void ProcessStopsInAreaResponse(json::Builder& builder, const json::Dict& request_map, int id);
+    void ProcessRouteResponse(json::Builder& builder, const json::Dict& request_map, int id,
+                              const std::optional<transport::RouteInfo>& route_info);
+    void ProcessRouterStatsResponse(json::Builder& builder, int id);
+    const transport::Router& GetRouter();
+    // Ответы на все запросы "Route" по индексам запросов
+    std::vector<std::optional<transport::RouteInfo>> ComputeRoutes(const json::Array& requests);
 };
 
 class StatReader {
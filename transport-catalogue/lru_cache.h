@@ -0,0 +1,101 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <functional>
+#include <list>
+#include <mutex>
+#include <optional>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace cache {
+
+struct CacheStats {
+    size_t hits = 0;
+    size_t misses = 0;
+    size_t size = 0;
+};
+
+// Ограниченный кэш с вытеснением давно не использованных записей.
+// Ключи распределены по независимым сегментам со своими мьютексами,
+// поэтому обращения из разных потоков к разным сегментам не мешают
+// друг другу. Ёмкость делится между сегментами поровну; нулевая ёмкость
+// отключает кэш.
+template <typename Key, typename Value, typename Hash = std::hash<Key>>
+class ShardedLruCache {
+public:
+    explicit ShardedLruCache(size_t capacity = 0, size_t shard_count = DEFAULT_SHARD_COUNT)
+        : shard_capacity_(capacity == 0 ? 0 : (capacity + shard_count - 1) / shard_count)
+        , shards_(capacity == 0 ? 0 : shard_count)
+    {
+    }
+
+    std::optional<Value> Get(const Key& key) {
+        if (shards_.empty()) {
+            ++misses_;
+            return std::nullopt;
+        }
+        Shard& shard = GetShard(key);
+        std::lock_guard guard(shard.mutex);
+        const auto it = shard.index.find(key);
+        if (it == shard.index.end()) {
+            ++misses_;
+            return std::nullopt;
+        }
+        ++hits_;
+        // Найденная запись переносится в начало списка как самая свежая
+        shard.entries.splice(shard.entries.begin(), shard.entries, it->second);
+        return it->second->second;
+    }
+
+    void Put(const Key& key, Value value) {
+        if (shards_.empty()) {
+            return;
+        }
+        Shard& shard = GetShard(key);
+        std::lock_guard guard(shard.mutex);
+        if (const auto it = shard.index.find(key); it != shard.index.end()) {
+            it->second->second = std::move(value);
+            shard.entries.splice(shard.entries.begin(), shard.entries, it->second);
+            return;
+        }
+        if (shard.entries.size() == shard_capacity_) {
+            shard.index.erase(shard.entries.back().first);
+            shard.entries.pop_back();
+        }
+        shard.entries.emplace_front(key, std::move(value));
+        shard.index.emplace(key, shard.entries.begin());
+    }
+
+    CacheStats GetStats() const {
+        CacheStats stats{hits_.load(), misses_.load(), 0};
+        for (const Shard& shard : shards_) {
+            std::lock_guard guard(shard.mutex);
+            stats.size += shard.entries.size();
+        }
+        return stats;
+    }
+
+private:
+    static constexpr size_t DEFAULT_SHARD_COUNT = 16;
+
+    struct Shard {
+        mutable std::mutex mutex;
+        // Записи от самой свежей к самой старой
+        std::list<std::pair<Key, Value>> entries;
+        std::unordered_map<Key, typename std::list<std::pair<Key, Value>>::iterator, Hash> index;
+    };
+
+    Shard& GetShard(const Key& key) {
+        return shards_[Hash{}(key) % shards_.size()];
+    }
+
+    size_t shard_capacity_ = 0;
+    std::vector<Shard> shards_;
+    std::atomic<size_t> hits_{0};
+    std::atomic<size_t> misses_{0};
+};
+
+}  // namespace cache
@@ -57,10 +57,10 @@ void MapRenderer::Render(std::ostream& out) const {
     }
 
     // Создаем множество остановок, которые принадлежат хотя бы одному маршруту
-    std::unordered_set<std::string> stops_in_routes;
+    std::unordered_set<std::string_view> stops_in_routes;
     for (const auto& bus : all_buses) {
-        for (const auto& stop : bus.stops) {
-            stops_in_routes.insert(stop->name);
+        for (const auto stop_id : bus.stops) {
+            stops_in_routes.insert(catalogue_.GetStopById(stop_id).name);
         }
     }
 
@@ -113,14 +113,14 @@ void MapRenderer::DrawRoutes(svg::Document& doc, const SphereProjector& projecto
 // Отрисовка одного маршрута
 void MapRenderer::DrawRoute(svg::Document& doc, const transport_catalogue::Bus& bus, const SphereProjector& projector, const Color& color) const {
     svg::Polyline polyline;
-    for (const auto& stop : bus.stops) {
-        auto point = projector(stop->coordinates);
+    for (const auto stop_id : bus.stops) {
+        auto point = projector(catalogue_.GetStopById(stop_id).coordinates);
         polyline.AddPoint(point);
     }
     if (!bus.is_round_trip) {
         // Для некольцевых маршрутов добавляем точки в обратном порядке, кроме последней остановки
         for (auto it = std::next(bus.stops.rbegin()); it != bus.stops.rend(); ++it) {
-            auto point = projector((*it)->coordinates);
+            auto point = projector(catalogue_.GetStopById(*it).coordinates);
             polyline.AddPoint(point);
         }
     }
@@ -152,10 +152,10 @@ void MapRenderer::DrawStops(svg::Document& doc, const SphereProjector& projector
     const auto& all_buses = catalogue_.GetAllBuses();
 
     // Создаем множество остановок, которые принадлежат хотя бы одному маршруту
-    std::unordered_set<std::string> stops_in_routes;
+    std::unordered_set<std::string_view> stops_in_routes;
     for (const auto& bus : all_buses) {
-        for (const auto& stop : bus.stops) {
-            stops_in_routes.insert(stop->name);
+        for (const auto stop_id : bus.stops) {
+            stops_in_routes.insert(catalogue_.GetStopById(stop_id).name);
         }
     }
 
@@ -182,7 +182,7 @@ void MapRenderer::DrawStops(svg::Document& doc, const SphereProjector& projector
 
         label.SetFontSize(settings_.stop_label_font_size);
         label.SetFontFamily("Verdana");
-        label.SetData(stop.name);
+        label.SetData(std::string(stop.name));
         label.SetFillColor("black");
         doc.Add(label);
     }
@@ -203,10 +203,10 @@ void MapRenderer::DrawStopCircles(svg::Document& doc, const SphereProjector& pro
     const auto& all_buses = catalogue_.GetAllBuses();
 
     // Создаем множество остановок, которые принадлежат хотя бы одному маршруту
-    std::unordered_set<std::string> stops_in_routes;
+    std::unordered_set<std::string_view> stops_in_routes;
     for (const auto& bus : all_buses) {
-        for (const auto& stop : bus.stops) {
-            stops_in_routes.insert(stop->name);
+        for (const auto stop_id : bus.stops) {
+            stops_in_routes.insert(catalogue_.GetStopById(stop_id).name);
         }
     }
 
@@ -236,10 +236,10 @@ void MapRenderer::DrawStopLabels(svg::Document& doc, const SphereProjector& proj
     const auto& all_buses = catalogue_.GetAllBuses();
 
     // Создаем множество остановок, которые принадлежат хотя бы одному маршруту
-    std::unordered_set<std::string> stops_in_routes;
+    std::unordered_set<std::string_view> stops_in_routes;
     for (const auto& bus : all_buses) {
-        for (const auto& stop : bus.stops) {
-            stops_in_routes.insert(stop->name);
+        for (const auto stop_id : bus.stops) {
+            stops_in_routes.insert(catalogue_.GetStopById(stop_id).name);
         }
     }
 
@@ -263,7 +263,7 @@ void MapRenderer::DrawStopLabels(svg::Document& doc, const SphereProjector& proj
         underlayer.SetOffset({settings_.stop_label_offset[0], settings_.stop_label_offset[1]});
         underlayer.SetFontSize(settings_.stop_label_font_size);
         underlayer.SetFontFamily("Verdana");
-        underlayer.SetData(stop.name);
+        underlayer.SetData(std::string(stop.name));
         underlayer.SetFillColor(ConvertColor(settings_.underlayer_color));
         underlayer.SetStrokeColor(ConvertColor(settings_.underlayer_color));
         underlayer.SetStrokeWidth(settings_.underlayer_width);
@@ -277,13 +277,13 @@ void MapRenderer::DrawStopLabels(svg::Document& doc, const SphereProjector& proj
         label.SetOffset({settings_.stop_label_offset[0], settings_.stop_label_offset[1]});
         label.SetFontSize(settings_.stop_label_font_size);
         label.SetFontFamily("Verdana");
-        label.SetData(stop.name);
+        label.SetData(std::string(stop.name));
         label.SetFillColor("black");
         doc.Add(label);
     }
 }
 
-void MapRenderer::DrawRouteLabel(svg::Document& doc, const SphereProjector& projector, geo::Coordinates coords, const std::string& name, const Color& color) const {
+void MapRenderer::DrawRouteLabel(svg::Document& doc, const SphereProjector& projector, geo::Coordinates coords, std::string_view name, const Color& color) const {
     auto point = projector(coords);
 
     // Подложка
@@ -293,7 +293,7 @@ void MapRenderer::DrawRouteLabel(svg::Document& doc, const SphereProjector& proj
     underlayer.SetFontSize(settings_.bus_label_font_size);
     underlayer.SetFontFamily("Verdana");
     underlayer.SetFontWeight("bold");
-    underlayer.SetData(name);
+    underlayer.SetData(std::string(name));
     underlayer.SetFillColor(ConvertColor(settings_.underlayer_color));
     underlayer.SetStrokeColor(ConvertColor(settings_.underlayer_color));
     underlayer.SetStrokeWidth(settings_.underlayer_width);
@@ -308,7 +308,7 @@ void MapRenderer::DrawRouteLabel(svg::Document& doc, const SphereProjector& proj
     label.SetFontSize(settings_.bus_label_font_size);
     label.SetFontFamily("Verdana");
     label.SetFontWeight("bold");
-    label.SetData(name);
+    label.SetData(std::string(name));
     label.SetFillColor(ConvertColor(color));
     doc.Add(label);
 }
@@ -328,16 +328,18 @@ void MapRenderer::DrawRouteLabels(svg::Document& doc, const SphereProjector& pro
         auto color = GetRouteColor(std::distance(buses.begin(), std::find(buses.begin(), buses.end(), bus)));
 
         // Если маршрут некольцевой и первая и последняя остановки совпадают, выводим имя только один раз
-        if (!bus.is_round_trip && bus.stops.front()->name == bus.stops.back()->name) {
-            DrawRouteLabel(doc, projector, bus.stops.front()->coordinates, bus.name, color);
+        const auto& first_stop = catalogue_.GetStopById(bus.stops.front());
+        const auto& last_stop = catalogue_.GetStopById(bus.stops.back());
+        if (!bus.is_round_trip && first_stop.name == last_stop.name) {
+            DrawRouteLabel(doc, projector, first_stop.coordinates, bus.name, color);
             } 
         else {
             // Отрисовываем название маршрута у первой конечной остановки
-            DrawRouteLabel(doc, projector, bus.stops.front()->coordinates, bus.name, color);
+            DrawRouteLabel(doc, projector, first_stop.coordinates, bus.name, color);
 
             // Если маршрут некольцевой, отрисовываем название у второй конечной остановки
             if (!bus.is_round_trip) {
-                DrawRouteLabel(doc, projector, bus.stops.back()->coordinates, bus.name, color);
+                DrawRouteLabel(doc, projector, last_stop.coordinates, bus.name, color);
             }
         }
     }
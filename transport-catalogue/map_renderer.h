@@ -2,6 +2,7 @@
 
 #include <vector>
 #include <string>
+#include <string_view>
 #include <map>
 #include <variant>
 #include <array>
@@ -79,7 +80,7 @@ private:
     void DrawStopCircles(svg::Document& doc, const SphereProjector& projector) const;
     void DrawStopLabels(svg::Document& doc, const SphereProjector& projector) const;
     void DrawRouteLabels(svg::Document& doc, const SphereProjector& projector) const;
-    void DrawRouteLabel(svg::Document& doc, const SphereProjector& projector, geo::Coordinates coords, const std::string& name, const Color& color) const;
+    void DrawRouteLabel(svg::Document& doc, const SphereProjector& projector, geo::Coordinates coords, std::string_view name, const Color& color) const;
 
     Color GetRouteColor(size_t index) const;
 };
@@ -0,0 +1,164 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace parallel {
+
+// Число рабочих потоков: по числу ядер, но не меньше одного
+inline size_t GetWorkerCount() {
+    return std::max<size_t>(1, std::thread::hardware_concurrency());
+}
+
+// Постоянный пул из GetWorkerCount() - 1 потоков, создаётся при первом
+// обращении и живёт до завершения программы
+class ThreadPool {
+public:
+    static ThreadPool& GetInstance() {
+        static ThreadPool pool(GetWorkerCount() - 1);
+        return pool;
+    }
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    ~ThreadPool() {
+        {
+            std::lock_guard guard(mutex_);
+            stopped_ = true;
+        }
+        task_added_.notify_all();
+        for (auto& thread : threads_) {
+            thread.join();
+        }
+    }
+
+    size_t GetThreadCount() const {
+        return threads_.size();
+    }
+
+    void Submit(std::function<void()> task) {
+        {
+            std::lock_guard guard(mutex_);
+            tasks_.push_back(std::move(task));
+        }
+        task_added_.notify_one();
+    }
+
+private:
+    explicit ThreadPool(size_t thread_count) {
+        threads_.reserve(thread_count);
+        for (size_t i = 0; i < thread_count; ++i) {
+            threads_.emplace_back([this]() {
+                Work();
+            });
+        }
+    }
+
+    void Work() {
+        for (;;) {
+            std::function<void()> task;
+            {
+                std::unique_lock lock(mutex_);
+                task_added_.wait(lock, [this]() {
+                    return stopped_ || !tasks_.empty();
+                });
+                if (tasks_.empty()) {
+                    return;
+                }
+                task = std::move(tasks_.front());
+                tasks_.pop_front();
+            }
+            task();
+        }
+    }
+
+    std::mutex mutex_;
+    std::condition_variable task_added_;
+    std::deque<std::function<void()>> tasks_;
+    bool stopped_ = false;
+    std::vector<std::thread> threads_;
+};
+
+// Вызывает func(index) для каждого index из [0, count) на потоках пула
+// и в вызывающем потоке. Задачи раздаются по одной через атомарный
+// счётчик, поэтому длинные и короткие задачи балансируются сами.
+// Вызывающий поток разбирает задачи наравне с пулом и ждёт только уже
+// начатые, так что вложенный ParallelFor из задачи не блокируется.
+// Первое исключение из задачи пробрасывается в вызывающий поток, после
+// него оставшиеся задачи пропускаются.
+template <typename Func>
+void ParallelFor(size_t count, Func&& func) {
+    ThreadPool& pool = ThreadPool::GetInstance();
+    const size_t helper_count = std::min(pool.GetThreadCount(), count > 0 ? count - 1 : 0);
+    if (helper_count == 0) {
+        for (size_t index = 0; index < count; ++index) {
+            func(index);
+        }
+        return;
+    }
+
+    // Помощник может начать работу уже после возврата из ParallelFor,
+    // поэтому общее состояние живёт в shared_ptr; func он тогда не вызовет
+    struct Batch {
+        std::atomic<size_t> next_index{0};
+        std::atomic<size_t> done_count{0};
+        std::atomic<bool> failed{false};
+        size_t count = 0;
+        std::function<void(size_t)> func;
+        std::mutex mutex;
+        std::condition_variable finished;
+        std::exception_ptr error;
+    };
+    auto batch = std::make_shared<Batch>();
+    batch->count = count;
+    batch->func = [&func](size_t index) {
+        func(index);
+    };
+
+    const auto drain = [](Batch& batch) {
+        for (size_t index = batch.next_index++; index < batch.count; index = batch.next_index++) {
+            if (!batch.failed) {
+                try {
+                    batch.func(index);
+                } catch (...) {
+                    std::lock_guard guard(batch.mutex);
+                    if (!batch.error) {
+                        batch.error = std::current_exception();
+                    }
+                    batch.failed = true;
+                }
+            }
+            if (++batch.done_count == batch.count) {
+                std::lock_guard guard(batch.mutex);
+                batch.finished.notify_all();
+            }
+        }
+    };
+
+    for (size_t i = 0; i < helper_count; ++i) {
+        pool.Submit([batch, drain]() {
+            drain(*batch);
+        });
+    }
+    drain(*batch);
+
+    std::unique_lock lock(batch->mutex);
+    batch->finished.wait(lock, [&]() {
+        return batch->done_count == count;
+    });
+    if (batch->error) {
+        std::rethrow_exception(batch->error);
+    }
+}
+
+}  // namespace parallel
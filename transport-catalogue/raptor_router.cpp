@@ -0,0 +1,215 @@
+#include "raptor_router.h"
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace transport {
+
+RaptorRouter::RaptorRouter(const transport_catalogue::TransportCatalogue& catalogue, const RouterSettings& settings)
+    : stop_count_(catalogue.GetAllStops().size())
+    , wait_time_(static_cast<double>(settings.bus_wait_time))
+    , velocity_(settings.bus_velocity * 1000.0 / 60.0)
+    , fewest_transfers_(settings.fewest_transfers)
+{
+    for (const auto& [bus_name, bus] : catalogue.GetSortedAllBuses()) {
+        AddPattern(catalogue, bus->id, bus->stops);
+        // Некольцевой маршрут проходится и в обратную сторону
+        if (!bus->is_round_trip) {
+            std::vector<transport_catalogue::StopId> reversed_stops(bus->stops.rbegin(), bus->stops.rend());
+            AddPattern(catalogue, bus->id, reversed_stops);
+        }
+    }
+
+    stop_pattern_offsets_.assign(stop_count_ + 1, 0);
+    for (const auto stop_id : pattern_stops_) {
+        ++stop_pattern_offsets_[stop_id + 1];
+    }
+    for (size_t stop_id = 0; stop_id < stop_count_; ++stop_id) {
+        stop_pattern_offsets_[stop_id + 1] += stop_pattern_offsets_[stop_id];
+    }
+    stop_patterns_.resize(pattern_stops_.size());
+    std::vector<uint32_t> next_slots(stop_pattern_offsets_.begin(), stop_pattern_offsets_.end() - 1);
+    for (uint32_t pattern_id = 0; pattern_id < patterns_.size(); ++pattern_id) {
+        const Pattern& pattern = patterns_[pattern_id];
+        for (uint32_t position = 0; position < pattern.size; ++position) {
+            const auto stop_id = pattern_stops_[pattern.begin + position];
+            stop_patterns_[next_slots[stop_id]++] = {pattern_id, position};
+        }
+    }
+}
+
+void RaptorRouter::SetProfile(const RoutingProfile& profile) {
+    wait_time_ = static_cast<double>(profile.bus_wait_time);
+    velocity_ = profile.bus_velocity * 1000.0 / 60.0;
+}
+
+void RaptorRouter::AddPattern(const transport_catalogue::TransportCatalogue& catalogue,
+                              transport_catalogue::BusId bus_id,
+                              const std::vector<transport_catalogue::StopId>& stops) {
+    if (stops.size() < 2) {
+        return;
+    }
+    patterns_.push_back({bus_id, static_cast<uint32_t>(pattern_stops_.size()), static_cast<uint32_t>(stops.size())});
+    const std::vector<int> segments = catalogue.GetSegmentDistances(stops);
+    int distance = 0;
+    for (size_t k = 0; k < stops.size(); ++k) {
+        if (k > 0) {
+            distance += segments[k - 1];
+        }
+        pattern_stops_.push_back(stops[k]);
+        pattern_distances_.push_back(distance);
+    }
+}
+
+double RaptorRouter::GetRideTime(const Pattern& pattern, uint32_t board_position, uint32_t alight_position) const {
+    const int distance = pattern_distances_[pattern.begin + alight_position]
+                       - pattern_distances_[pattern.begin + board_position];
+    return distance / velocity_;
+}
+
+void RaptorRouter::Search(SearchState& state, transport_catalogue::StopId from,
+                          std::optional<transport_catalogue::StopId> target) const {
+    if (from >= stop_count_ || (target && *target >= stop_count_)) {
+        throw std::out_of_range("Stop id is out of range");
+    }
+
+    state.labels.assign(stop_count_, Label{});
+    state.best_arrivals.assign(stop_count_, INFINITE_TIME);
+    state.pattern_first_positions.assign(patterns_.size(), NO_INDEX);
+    state.is_marked.assign(stop_count_, false);
+    state.marked_stops.clear();
+
+    state.labels[from].arrival = 0.0;
+    state.best_arrivals[from] = 0.0;
+    state.marked_stops.push_back(from);
+    state.round_count = 1;
+
+    while (!state.marked_stops.empty()) {
+        // Метки нового раунда начинаются с времён прошлого раунда
+        const size_t round_begin = state.round_count * stop_count_;
+        state.labels.resize(round_begin + stop_count_);
+        for (size_t stop_id = 0; stop_id < stop_count_; ++stop_id) {
+            state.labels[round_begin + stop_id] = Label{state.labels[round_begin - stop_count_ + stop_id].arrival};
+        }
+        const Label* previous = &state.labels[round_begin - stop_count_];
+        Label* current = &state.labels[round_begin];
+        ++state.round_count;
+
+        // Каждый проход сканируется один раз, с самой ранней отмеченной остановки
+        state.touched_patterns.clear();
+        for (const auto stop_id : state.marked_stops) {
+            state.is_marked[stop_id] = false;
+            for (uint32_t i = stop_pattern_offsets_[stop_id]; i < stop_pattern_offsets_[stop_id + 1]; ++i) {
+                const auto [pattern_id, position] = stop_patterns_[i];
+                uint32_t& first_position = state.pattern_first_positions[pattern_id];
+                if (first_position == NO_INDEX) {
+                    state.touched_patterns.push_back(pattern_id);
+                }
+                first_position = std::min(first_position, position);
+            }
+        }
+        state.marked_stops.clear();
+
+        for (const auto pattern_id : state.touched_patterns) {
+            const Pattern& pattern = patterns_[pattern_id];
+            const uint32_t first_position = state.pattern_first_positions[pattern_id];
+            state.pattern_first_positions[pattern_id] = NO_INDEX;
+
+            uint32_t board_position = NO_INDEX;
+            double board_arrival = INFINITE_TIME;
+            for (uint32_t position = first_position; position < pattern.size; ++position) {
+                const auto stop_id = pattern_stops_[pattern.begin + position];
+                if (board_position != NO_INDEX) {
+                    const double arrival = board_arrival + wait_time_ + GetRideTime(pattern, board_position, position);
+                    const double bound = target ? std::min(state.best_arrivals[stop_id], state.best_arrivals[*target])
+                                                : state.best_arrivals[stop_id];
+                    if (arrival < bound) {
+                        current[stop_id] = {arrival, pattern_id, board_position, position};
+                        state.best_arrivals[stop_id] = arrival;
+                        if (!state.is_marked[stop_id]) {
+                            state.is_marked[stop_id] = true;
+                            state.marked_stops.push_back(stop_id);
+                        }
+                    }
+                }
+                // Пересесть на этот же автобус здесь выгоднее, чем ехать дальше
+                // с прежней посадки, если сюда можно добраться раньше
+                const double arrival_here = previous[stop_id].arrival;
+                if (arrival_here < INFINITE_TIME
+                    && (board_position == NO_INDEX
+                        || arrival_here < board_arrival + GetRideTime(pattern, board_position, position))) {
+                    board_position = position;
+                    board_arrival = arrival_here;
+                }
+            }
+        }
+
+        if (fewest_transfers_ && target && current[*target].arrival < INFINITE_TIME) {
+            break;
+        }
+    }
+}
+
+std::optional<RouteInfo> RaptorRouter::ExtractRoute(const SearchState& state, transport_catalogue::StopId to) const {
+    const double best_arrival = state.best_arrivals[to];
+    if (best_arrival == INFINITE_TIME) {
+        return std::nullopt;
+    }
+
+    // Первый раунд, где цель достигнута (минимум поездок) либо где её
+    // время прибытия стало лучшим (минимум времени)
+    size_t round = 0;
+    while (fewest_transfers_ ? state.labels[round * stop_count_ + to].arrival == INFINITE_TIME
+                             : state.labels[round * stop_count_ + to].arrival != best_arrival) {
+        ++round;
+    }
+
+    std::vector<Label> legs;
+    for (auto stop_id = to; round > 0; --round) {
+        const Label& label = state.labels[round * stop_count_ + stop_id];
+        if (label.pattern != NO_INDEX) {
+            legs.push_back(label);
+            stop_id = pattern_stops_[patterns_[label.pattern].begin + label.board_position];
+        }
+    }
+    std::reverse(legs.begin(), legs.end());
+
+    RouteInfo result;
+    result.items.reserve(legs.size() * 2);
+    for (const Label& leg : legs) {
+        const Pattern& pattern = patterns_[leg.pattern];
+        const double ride_time = GetRideTime(pattern, leg.board_position, leg.alight_position);
+        result.items.push_back(WaitItem{pattern_stops_[pattern.begin + leg.board_position], wait_time_});
+        result.items.push_back(BusItem{pattern.bus_id, leg.alight_position - leg.board_position, ride_time});
+        result.total_time += wait_time_;
+        result.total_time += ride_time;
+    }
+    return result;
+}
+
+std::optional<RouteInfo> RaptorRouter::BuildRoute(transport_catalogue::StopId from,
+                                                  transport_catalogue::StopId to) const {
+    SearchState& state = GetSearchState();
+    Search(state, from, to);
+    return ExtractRoute(state, to);
+}
+
+std::vector<std::optional<RouteInfo>> RaptorRouter::BuildRoutes(
+        transport_catalogue::StopId from, const std::vector<transport_catalogue::StopId>& targets) const {
+    for (const auto to : targets) {
+        if (to >= stop_count_) {
+            throw std::out_of_range("Stop id is out of range");
+        }
+    }
+    SearchState& state = GetSearchState();
+    Search(state, from, std::nullopt);
+
+    std::vector<std::optional<RouteInfo>> routes;
+    routes.reserve(targets.size());
+    for (const auto to : targets) {
+        routes.push_back(ExtractRoute(state, to));
+    }
+    return routes;
+}
+
+}  // namespace transport
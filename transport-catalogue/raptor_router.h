@@ -0,0 +1,94 @@
+#pragma once
+
+#include "transport_catalogue.h"
+#include "transport_router.h"
+
+#include <cstdint>
+#include <limits>
+#include <optional>
+#include <vector>
+
+namespace transport {
+
+// Поиск маршрутов алгоритмом RAPTOR прямо по последовательностям остановок
+// маршрутов каталога, без графа и предварительного расчёта. Расписания нет,
+// поэтому каждая посадка стоит bus_wait_time минут ожидания, а поездка —
+// расстояние по дороге, делённое на скорость автобуса. Раунд k находит
+// лучшее время прибытия на каждую остановку не более чем за k поездок;
+// маршрут с минимальным числом пересадок — первый раунд, достигший цели.
+class RaptorRouter {
+public:
+    RaptorRouter(const transport_catalogue::TransportCatalogue& catalogue, const RouterSettings& settings);
+
+    // Время ожидания и скорость; структура маршрутов от них не зависит
+    void SetProfile(const RoutingProfile& profile);
+
+    std::optional<RouteInfo> BuildRoute(transport_catalogue::StopId from, transport_catalogue::StopId to) const;
+    // Все цели из одного запуска, ответы в порядке targets
+    std::vector<std::optional<RouteInfo>> BuildRoutes(transport_catalogue::StopId from,
+                                                      const std::vector<transport_catalogue::StopId>& targets) const;
+
+private:
+    static constexpr uint32_t NO_INDEX = std::numeric_limits<uint32_t>::max();
+    static constexpr double INFINITE_TIME = std::numeric_limits<double>::infinity();
+
+    // Проход автобуса в одну сторону: для некольцевого маршрута их два.
+    // Остановки и префиксные расстояния лежат подряд в общих массивах.
+    struct Pattern {
+        transport_catalogue::BusId bus_id = 0;
+        uint32_t begin = 0;
+        uint32_t size = 0;
+    };
+
+    struct PatternStop {
+        uint32_t pattern = 0;
+        uint32_t position = 0;
+    };
+
+    // Метка остановки в раунде: время прибытия и последняя поездка,
+    // либо NO_INDEX в pattern, если время перенесено из прошлого раунда
+    struct Label {
+        double arrival = INFINITE_TIME;
+        uint32_t pattern = NO_INDEX;
+        uint32_t board_position = 0;
+        uint32_t alight_position = 0;
+    };
+
+    struct SearchState {
+        std::vector<Label> labels;  // раунды подряд, по stop_count_ меток
+        std::vector<double> best_arrivals;
+        std::vector<uint32_t> pattern_first_positions;
+        std::vector<uint32_t> touched_patterns;
+        std::vector<transport_catalogue::StopId> marked_stops;
+        std::vector<bool> is_marked;
+        size_t round_count = 0;
+    };
+
+    static SearchState& GetSearchState() {
+        static thread_local SearchState state;
+        return state;
+    }
+
+    // Раунды RAPTOR из from; если target задан, поиск отсекается по
+    // лучшему известному времени прибытия в него
+    void Search(SearchState& state, transport_catalogue::StopId from,
+                std::optional<transport_catalogue::StopId> target) const;
+    std::optional<RouteInfo> ExtractRoute(const SearchState& state, transport_catalogue::StopId to) const;
+    void AddPattern(const transport_catalogue::TransportCatalogue& catalogue,
+                    transport_catalogue::BusId bus_id,
+                    const std::vector<transport_catalogue::StopId>& stops);
+    double GetRideTime(const Pattern& pattern, uint32_t board_position, uint32_t alight_position) const;
+
+    size_t stop_count_ = 0;
+    double wait_time_ = 0.0;
+    double velocity_ = 0.0;  // метров в минуту
+    bool fewest_transfers_ = false;
+    std::vector<Pattern> patterns_;
+    std::vector<transport_catalogue::StopId> pattern_stops_;
+    std::vector<int> pattern_distances_;
+    // Проходы через каждую остановку в формате CSR
+    std::vector<uint32_t> stop_pattern_offsets_;
+    std::vector<PatternStop> stop_patterns_;
+};
+
+}  // namespace transport
@@ -0,0 +1,69 @@
+#pragma once
+
+#include "graph.h"
+
+#include <atomic>
+#include <cstddef>
+#include <optional>
+#include <vector>
+
+namespace graph {
+
+template <typename Weight>
+struct RouteInfo {
+    Weight weight;
+    std::vector<EdgeId> edges;
+};
+
+// Счётчики поиска: сколько запросов дошло до движка и сколько вершин они
+// просмотрели (извлекли из очереди с окончательным весом)
+struct SearchStats {
+    size_t queries = 0;
+    size_t settled_vertices = 0;
+};
+
+// Потокобезопасное накопление SearchStats
+class SearchCounters {
+public:
+    void Add(size_t settled_vertices) const {
+        queries_.fetch_add(1, std::memory_order_relaxed);
+        settled_vertices_.fetch_add(settled_vertices, std::memory_order_relaxed);
+    }
+
+    SearchStats Get() const {
+        return {queries_.load(), settled_vertices_.load()};
+    }
+
+private:
+    mutable std::atomic<size_t> queries_{0};
+    mutable std::atomic<size_t> settled_vertices_{0};
+};
+
+// Общий интерфейс движков поиска кратчайшего пути
+template <typename Weight>
+class RouteEngine {
+public:
+    virtual ~RouteEngine() = default;
+
+    virtual std::optional<RouteInfo<Weight>> BuildRoute(VertexId from, VertexId to) const = 0;
+
+    // Маршруты из одной вершины во все targets, ответы в порядке targets.
+    // По умолчанию — отдельный BuildRoute на каждую цель; движки, которые
+    // умеют строить дерево кратчайших путей, переопределяют метод.
+    virtual std::vector<std::optional<RouteInfo<Weight>>> BuildRoutes(VertexId from,
+                                                                      const std::vector<VertexId>& targets) const {
+        std::vector<std::optional<RouteInfo<Weight>>> routes;
+        routes.reserve(targets.size());
+        for (const VertexId to : targets) {
+            routes.push_back(BuildRoute(from, to));
+        }
+        return routes;
+    }
+
+    // Движки без поиска по графу (таблицы всех пар) ничего не считают
+    virtual SearchStats GetSearchStats() const {
+        return {};
+    }
+};
+
+}  // namespace graph
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "graph.h"
+#include "route_engine.h"
 
 #include <algorithm>
 #include <cassert>
@@ -15,19 +16,16 @@
 namespace graph {
 
 template <typename Weight>
-class Router {
+class Router : public RouteEngine<Weight> {
 private:
     using Graph = DirectedWeightedGraph<Weight>;
 
 public:
     explicit Router(const Graph& graph);
 
-    struct RouteInfo {
-        Weight weight;
-        std::vector<EdgeId> edges;
-    };
+    using RouteInfo = graph::RouteInfo<Weight>;
 
-    std::optional<RouteInfo> BuildRoute(VertexId from, VertexId to) const;
+    std::optional<RouteInfo> BuildRoute(VertexId from, VertexId to) const override;
 
 private:
     struct RouteInternalData {
@@ -40,16 +38,15 @@ private:
         const size_t vertex_count = graph.GetVertexCount();
         for (VertexId vertex = 0; vertex < vertex_count; ++vertex) {
             routes_internal_data_[vertex][vertex] = RouteInternalData{ZERO_WEIGHT, std::nullopt};
-            for (const EdgeId edge_id : graph.GetIncidentEdges(vertex)) {
-                const auto& edge = graph.GetEdge(edge_id);
-                if (edge.weight < ZERO_WEIGHT) {
+            graph.ForEachIncidentEdge(vertex, [&](EdgeId edge_id, VertexId edge_to, Weight edge_weight) {
+                if (edge_weight < ZERO_WEIGHT) {
                     throw std::domain_error("Edges' weights should be non-negative");
                 }
-                auto& route_internal_data = routes_internal_data_[vertex][edge.to];
-                if (!route_internal_data || route_internal_data->weight > edge.weight) {
-                    route_internal_data = RouteInternalData{edge.weight, edge_id};
+                auto& route_internal_data = routes_internal_data_[vertex][edge_to];
+                if (!route_internal_data || route_internal_data->weight > edge_weight) {
+                    route_internal_data = RouteInternalData{edge_weight, edge_id};
                 }
-            }
+            });
         }
     }
 
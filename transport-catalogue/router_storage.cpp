@@ -0,0 +1,214 @@
+#include "router_storage.h"
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define TRANSPORT_HAS_MMAP 1
+#endif
+
+namespace transport {
+
+namespace {
+
+constexpr char FILE_MAGIC[8] = {'T', 'C', 'R', 'O', 'U', 'T', 'E', '\0'};
+// Повышается при любом изменении смысла хранимых рёбер или раскладки графа:
+// файл другой версии отвергается, и таблица пересчитывается. Версия 2:
+// веса рёбер в метрах вместо минут, только обслуживаемые остановки в порядке
+// обхода графа, вершины «в автобусе» модели маршрутов и пешие переходы.
+constexpr uint32_t FORMAT_VERSION = 2;
+constexpr uint32_t BYTE_ORDER_MARK = 0x01020304;
+constexpr size_t SECTION_ALIGNMENT = 64;
+
+struct FileHeader {
+    char magic[8];
+    uint32_t format_version;
+    uint32_t byte_order;
+    uint32_t word_size;
+    uint32_t engine;
+    uint64_t key;
+    uint64_t vertex_count;
+    uint64_t edge_count;
+    uint64_t section_count;
+};
+
+struct StoredEdge {
+    uint32_t name_id;
+    uint32_t span_count;
+    uint64_t from;
+    uint64_t to;
+    double weight;
+};
+
+struct SectionHeader {
+    uint64_t offset;
+    uint64_t size;
+};
+
+size_t AlignUp(size_t value) {
+    return (value + SECTION_ALIGNMENT - 1) / SECTION_ALIGNMENT * SECTION_ALIGNMENT;
+}
+
+}  // namespace
+
+std::unique_ptr<MappedFile> MappedFile::Open(const std::string& path) {
+    std::unique_ptr<MappedFile> file(new MappedFile());
+#ifdef TRANSPORT_HAS_MMAP
+    const int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return nullptr;
+    }
+    struct stat file_stat {};
+    if (fstat(fd, &file_stat) != 0 || file_stat.st_size == 0) {
+        close(fd);
+        return nullptr;
+    }
+    void* data = mmap(nullptr, static_cast<size_t>(file_stat.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED) {
+        return nullptr;
+    }
+    file->data_ = static_cast<const char*>(data);
+    file->size_ = static_cast<size_t>(file_stat.st_size);
+#else
+    std::ifstream input(path, std::ios::binary);
+    if (!input) {
+        return nullptr;
+    }
+    file->buffer_.assign(std::istreambuf_iterator<char>(input), std::istreambuf_iterator<char>());
+    file->data_ = file->buffer_.data();
+    file->size_ = file->buffer_.size();
+#endif
+    return file;
+}
+
+MappedFile::~MappedFile() {
+#ifdef TRANSPORT_HAS_MMAP
+    if (data_ != nullptr) {
+        munmap(const_cast<char*>(data_), size_);
+    }
+#endif
+}
+
+uint64_t HashBytes(std::string_view data, uint64_t hash) {
+    for (const char c : data) {
+        hash ^= static_cast<unsigned char>(c);
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+bool SaveRouterState(const std::string& path, uint64_t key, RouterEngine engine,
+                     const graph::DirectedWeightedGraph<double>& graph, const std::vector<StateSection>& sections) {
+    FileHeader header{};
+    std::memcpy(header.magic, FILE_MAGIC, sizeof(FILE_MAGIC));
+    header.format_version = FORMAT_VERSION;
+    header.byte_order = BYTE_ORDER_MARK;
+    header.word_size = sizeof(size_t);
+    header.engine = static_cast<uint32_t>(engine);
+    header.key = key;
+    header.vertex_count = graph.GetVertexCount();
+    header.edge_count = graph.GetEdgeCount();
+    header.section_count = sections.size();
+
+    std::vector<StoredEdge> edges(graph.GetEdgeCount());
+    for (graph::EdgeId edge_id = 0; edge_id < edges.size(); ++edge_id) {
+        const auto& edge = graph.GetEdge(edge_id);
+        edges[edge_id] = {edge.name_id, edge.span_count, edge.from, edge.to, edge.weight};
+    }
+
+    std::vector<SectionHeader> section_headers;
+    size_t offset = AlignUp(sizeof(FileHeader) + edges.size() * sizeof(StoredEdge)
+                            + sections.size() * sizeof(SectionHeader));
+    for (const auto& section : sections) {
+        section_headers.push_back({offset, section.size});
+        offset = AlignUp(offset + section.size);
+    }
+
+    const std::string temp_path = path + ".tmp";
+    {
+        std::ofstream output(temp_path, std::ios::binary | std::ios::trunc);
+        if (!output) {
+            return false;
+        }
+        const auto write = [&output](const void* data, size_t size) {
+            output.write(static_cast<const char*>(data), static_cast<std::streamsize>(size));
+        };
+        const auto pad_to = [&output](size_t position) {
+            static const char zeros[SECTION_ALIGNMENT] = {};
+            output.write(zeros, static_cast<std::streamsize>(position - static_cast<size_t>(output.tellp())));
+        };
+        write(&header, sizeof(header));
+        write(edges.data(), edges.size() * sizeof(StoredEdge));
+        write(section_headers.data(), section_headers.size() * sizeof(SectionHeader));
+        for (size_t i = 0; i < sections.size(); ++i) {
+            pad_to(section_headers[i].offset);
+            write(sections[i].data, sections[i].size);
+        }
+        if (!output) {
+            std::remove(temp_path.c_str());
+            return false;
+        }
+    }
+    return std::rename(temp_path.c_str(), path.c_str()) == 0;
+}
+
+std::optional<RouterState> LoadRouterState(const MappedFile& file, uint64_t key, RouterEngine engine) {
+    const char* data = file.GetData();
+    const size_t size = file.GetSize();
+
+    FileHeader header;
+    if (size < sizeof(header)) {
+        return std::nullopt;
+    }
+    std::memcpy(&header, data, sizeof(header));
+    if (std::memcmp(header.magic, FILE_MAGIC, sizeof(FILE_MAGIC)) != 0
+        || header.format_version != FORMAT_VERSION
+        || header.byte_order != BYTE_ORDER_MARK
+        || header.word_size != sizeof(size_t)
+        || header.engine != static_cast<uint32_t>(engine)
+        || header.key != key) {
+        return std::nullopt;
+    }
+
+    const size_t edges_offset = sizeof(header);
+    const size_t sections_offset = edges_offset + header.edge_count * sizeof(StoredEdge);
+    if (header.edge_count > size / sizeof(StoredEdge)
+        || header.section_count > size / sizeof(SectionHeader)
+        || sections_offset + header.section_count * sizeof(SectionHeader) > size) {
+        return std::nullopt;
+    }
+
+    RouterState state;
+    state.vertex_count = header.vertex_count;
+    state.edges.reserve(header.edge_count);
+    for (size_t i = 0; i < header.edge_count; ++i) {
+        StoredEdge edge;
+        std::memcpy(&edge, data + edges_offset + i * sizeof(StoredEdge), sizeof(edge));
+        if (edge.from >= header.vertex_count || edge.to >= header.vertex_count) {
+            return std::nullopt;
+        }
+        state.edges.push_back({edge.name_id, edge.span_count, edge.from, edge.to, edge.weight});
+    }
+    // Секции идут по порядку после таблицы секций и не перекрываются
+    size_t sections_end = sections_offset + header.section_count * sizeof(SectionHeader);
+    for (size_t i = 0; i < header.section_count; ++i) {
+        SectionHeader section;
+        std::memcpy(&section, data + sections_offset + i * sizeof(SectionHeader), sizeof(section));
+        if (section.offset % SECTION_ALIGNMENT != 0 || section.offset < sections_end || section.offset > size
+            || section.size > size - section.offset) {
+            return std::nullopt;
+        }
+        state.sections.push_back({data + section.offset, section.size});
+        sections_end = section.offset + section.size;
+    }
+    return state;
+}
+
+}  // namespace transport
@@ -0,0 +1,67 @@
+#pragma once
+
+#include "graph.h"
+#include "transport_router.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace transport {
+
+// Файл, отображённый в память только для чтения. Там, где нет mmap,
+// содержимое просто читается в буфер.
+class MappedFile {
+public:
+    // nullptr, если файл не удалось открыть
+    static std::unique_ptr<MappedFile> Open(const std::string& path);
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+    ~MappedFile();
+
+    const char* GetData() const {
+        return data_;
+    }
+
+    size_t GetSize() const {
+        return size_;
+    }
+
+private:
+    MappedFile() = default;
+
+    const char* data_ = nullptr;
+    size_t size_ = 0;
+    std::vector<char> buffer_;
+};
+
+// FNV-1a; hash позволяет продолжить хеширование следующего фрагмента
+uint64_t HashBytes(std::string_view data, uint64_t hash = 14695981039346656037ull);
+
+// Непрерывный кусок предрасчитанных данных движка
+struct StateSection {
+    const void* data = nullptr;
+    size_t size = 0;  // в байтах
+};
+
+struct RouterState {
+    size_t vertex_count = 0;
+    std::vector<graph::Edge<double>> edges;
+    std::vector<StateSection> sections;  // указывают внутрь отображённого файла
+};
+
+// Формат файла: заголовок с версией формата, движком и ключом исходных
+// данных, затем рёбра графа и таблица секций; сами секции выровнены на 64
+// байта, чтобы после отображения их можно было читать как массивы.
+// Запись идёт во временный файл, который затем переименовывается.
+bool SaveRouterState(const std::string& path, uint64_t key, RouterEngine engine,
+                     const graph::DirectedWeightedGraph<double>& graph, const std::vector<StateSection>& sections);
+// nullopt, если файл повреждён, другой версии или построен для других данных
+std::optional<RouterState> LoadRouterState(const MappedFile& file, uint64_t key, RouterEngine engine);
+
+}  // namespace transport
@@ -0,0 +1,70 @@
+// Замер предрасчёта всех пар: блочный Флойд-Уоршелл против graph::Router
+// на одном случайном графе, с проверкой совпадения весов.
+//
+// Сборка из каталога transport-catalogue:
+//   g++ -std=c++17 -O2 -pthread -I. tests/blocked_router_bench.cpp -o blocked_router_bench
+//   ./blocked_router_bench [vertex_count]
+
+#include "blocked_router.h"
+#include "router.h"
+
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <optional>
+#include <random>
+#include <string>
+
+namespace {
+
+template <typename Func>
+double MeasureMilliseconds(Func&& func) {
+    const auto start = std::chrono::steady_clock::now();
+    func();
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+    const size_t vertex_count = argc > 1 ? std::stoul(argv[1]) : 1024;
+    const size_t edge_count = vertex_count * 8;
+
+    graph::DirectedWeightedGraph<double> graph(vertex_count);
+    std::mt19937 random_engine(42);
+    std::uniform_int_distribution<size_t> vertex_distribution(0, vertex_count - 1);
+    std::uniform_real_distribution<double> weight_distribution(1.0, 100.0);
+    for (size_t i = 0; i < edge_count; ++i) {
+        graph.AddEdge({0, 1, vertex_distribution(random_engine), vertex_distribution(random_engine),
+                       weight_distribution(random_engine)});
+    }
+    graph.Freeze();
+
+    std::optional<graph::BlockedRouter<double>> blocked;
+    const double blocked_ms = MeasureMilliseconds([&]() {
+        blocked.emplace(graph);
+    });
+    std::optional<graph::Router<double>> reference;
+    const double reference_ms = MeasureMilliseconds([&]() {
+        reference.emplace(graph);
+    });
+
+    size_t mismatches = 0;
+    for (graph::VertexId from = 0; from < vertex_count; from += 7) {
+        for (graph::VertexId to = 0; to < vertex_count; to += 5) {
+            const auto expected = reference->BuildRoute(from, to);
+            const auto actual = blocked->BuildRoute(from, to);
+            if (expected.has_value() != actual.has_value()
+                || (expected && std::abs(expected->weight - actual->weight) > 1e-9)) {
+                ++mismatches;
+            }
+        }
+    }
+
+    std::cout << "vertices: " << vertex_count << ", edges: " << edge_count << "\n"
+              << "blocked Floyd-Warshall: " << blocked_ms << " ms\n"
+              << "graph::Router: " << reference_ms << " ms\n"
+              << "mismatches: " << mismatches << "\n";
+    return mismatches == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
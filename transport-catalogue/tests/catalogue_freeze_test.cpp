@@ -0,0 +1,127 @@
+// TransportCatalogue::Freeze(): поиск по названиям и номерам после
+// заморозки, запрет изменений, индекс остановок, статистика маршрутов
+// и замер кучи до и после (на glibc).
+//
+// Сборка из каталога transport-catalogue:
+//   g++ -std=c++17 -O2 -pthread -I. tests/catalogue_freeze_test.cpp transport_catalogue.cpp geo.cpp -o catalogue_freeze_test
+//   ./catalogue_freeze_test
+
+#include "check.h"
+#include "transport_catalogue.h"
+
+#include <cstddef>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#ifdef __GLIBC__
+#include <malloc.h>
+#endif
+
+namespace {
+
+constexpr int STOP_COUNT = 30000;
+constexpr int BUS_COUNT = 3000;
+constexpr int STOPS_PER_BUS = 20;
+
+std::string StopName(int index) {
+    return "Stop street number " + std::to_string(index);
+}
+
+std::string BusName(int index) {
+    return "Bus route " + std::to_string(index);
+}
+
+// Занятая память кучи в байтах, 0 — если замерить нельзя
+size_t GetHeapInUse() {
+#if defined(__GLIBC__) && (__GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 33))
+    return mallinfo2().uordblks;
+#else
+    return 0;
+#endif
+}
+
+template <typename Func>
+bool Throws(Func&& func) {
+    try {
+        func();
+    } catch (const std::logic_error&) {
+        return true;
+    }
+    return false;
+}
+
+}  // namespace
+
+int main() {
+    using namespace transport_catalogue;
+
+    TransportCatalogue catalogue;
+    for (int i = 0; i < STOP_COUNT; ++i) {
+        catalogue.AddStop(StopName(i), {55.0 + i * 1e-5, 37.0});
+    }
+    for (int i = 0; i < BUS_COUNT; ++i) {
+        std::vector<StopId> stops;
+        for (int k = 0; k < STOPS_PER_BUS; ++k) {
+            stops.push_back(static_cast<StopId>((i * 7 + k * 13) % STOP_COUNT));
+        }
+        catalogue.AddBus(BusName(i), stops, i % 2 == 0);
+    }
+    catalogue.SetDistance(0, 13, 1000);
+    // Индекс остановок и статистика маршрутов строятся только по
+    // замороженному каталогу
+    CHECK(Throws([&]() {
+        catalogue.PrepareStopIndex();
+    }));
+    CHECK(Throws([&]() {
+        catalogue.PrepareBusInfos();
+    }));
+
+    const size_t heap_before = GetHeapInUse();
+    catalogue.Freeze();
+    const size_t heap_after = GetHeapInUse();
+
+    for (int i = 0; i < STOP_COUNT; ++i) {
+        const Stop* stop = catalogue.FindStop(StopName(i));
+        CHECK(stop && stop->id == static_cast<StopId>(i) && stop->name == StopName(i));
+        CHECK(catalogue.GetStopById(stop->id).name == stop->name);
+    }
+    for (int i = 0; i < BUS_COUNT; ++i) {
+        const Bus* bus = catalogue.FindBus(BusName(i));
+        CHECK(bus && bus->id == static_cast<BusId>(i) && bus->name == BusName(i));
+        CHECK(bus->stops.size() == static_cast<size_t>(STOPS_PER_BUS));
+    }
+    CHECK(!catalogue.FindStop("Stop street number"));
+    CHECK(!catalogue.FindBus(StopName(0)));
+    CHECK(catalogue.GetDistance(0, 13) == 1000);
+    CHECK(catalogue.GetSortedAllStops().size() == static_cast<size_t>(STOP_COUNT));
+    CHECK(catalogue.GetSortedAllBuses().size() == static_cast<size_t>(BUS_COUNT));
+    CHECK(Throws([&]() {
+        catalogue.GetBusInfo(BusName(1), 1);
+    }));
+    catalogue.PrepareBusInfos();
+    CHECK(catalogue.GetBusInfo(BusName(1), 1).stop_count == STOPS_PER_BUS * 2 - 1);
+    CHECK(Throws([&]() {
+        catalogue.GetStopIndex();
+    }));
+    catalogue.PrepareStopIndex();
+    CHECK(catalogue.FindNearestStops({55.0, 37.0}, 1).front().id == 0);
+
+    CHECK(Throws([&]() {
+        catalogue.AddStop("New stop", {55.0, 37.0});
+    }));
+    CHECK(Throws([&]() {
+        catalogue.AddBus("New bus", {0, 1}, true);
+    }));
+    CHECK(Throws([&]() {
+        catalogue.SetDistance(1, 2, 100);
+    }));
+
+    if (heap_before != 0) {
+        CHECK(heap_after < heap_before);
+        std::cout << "heap in use: " << heap_before / 1e6 << " MB before Freeze(), "
+                  << heap_after / 1e6 << " MB after\n";
+    }
+    std::cout << "catalogue_freeze_test: OK" << std::endl;
+}
@@ -0,0 +1,15 @@
+#pragma once
+
+#include <cstdlib>
+#include <iostream>
+
+// Проверка для тестов без фреймворка: при нарушении условия печатает
+// место и выражение и завершает программу с ошибкой
+#define CHECK(condition)                                                              \
+    do {                                                                              \
+        if (!(condition)) {                                                           \
+            std::cerr << __FILE__ << ":" << __LINE__ << ": CHECK failed: " #condition \
+                      << std::endl;                                                   \
+            std::exit(EXIT_FAILURE);                                                  \
+        }                                                                             \
+    } while (false)
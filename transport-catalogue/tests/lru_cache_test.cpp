@@ -0,0 +1,81 @@
+// Порядок вытеснения и счётчики cache::ShardedLruCache.
+//
+// Сборка из каталога transport-catalogue:
+//   g++ -std=c++17 -O2 -pthread -I. tests/lru_cache_test.cpp -o lru_cache_test && ./lru_cache_test
+
+#include "check.h"
+#include "lru_cache.h"
+
+#include <cstddef>
+#include <iostream>
+
+namespace {
+
+// Ключ сам выбирает сегмент: key % shard_count
+struct IdentityHash {
+    size_t operator()(int key) const {
+        return static_cast<size_t>(key);
+    }
+};
+
+using Cache = cache::ShardedLruCache<int, int, IdentityHash>;
+
+void TestEvictsLeastRecentlyUsed() {
+    Cache cache(3, 1);
+    cache.Put(1, 10);
+    cache.Put(2, 20);
+    cache.Put(3, 30);
+    // Чтение делает запись самой свежей: вытесняется 2, а не 1
+    CHECK(cache.Get(1) == 10);
+    cache.Put(4, 40);
+    CHECK(!cache.Get(2));
+    CHECK(cache.Get(1) == 10);
+    CHECK(cache.Get(3) == 30);
+    CHECK(cache.Get(4) == 40);
+
+    // Порядок теперь 4, 3, 1; перезапись 1 тоже освежает её, вытесняется 3
+    cache.Put(1, 11);
+    cache.Put(5, 50);
+    CHECK(!cache.Get(3));
+    CHECK(cache.Get(1) == 11);
+    CHECK(cache.Get(4) == 40);
+    CHECK(cache.Get(5) == 50);
+
+    const cache::CacheStats stats = cache.GetStats();
+    CHECK(stats.hits == 7);
+    CHECK(stats.misses == 2);
+    CHECK(stats.size == 3);
+}
+
+void TestShardsEvictIndependently() {
+    // По две записи на сегмент
+    Cache cache(8, 4);
+    cache.Put(0, 0);
+    cache.Put(4, 4);
+    cache.Put(1, 1);
+    cache.Put(8, 8);  // третья запись сегмента 0 вытесняет 0
+    CHECK(!cache.Get(0));
+    CHECK(cache.Get(4) == 4);
+    CHECK(cache.Get(8) == 8);
+    CHECK(cache.Get(1) == 1);
+    CHECK(cache.GetStats().size == 3);
+}
+
+void TestZeroCapacityDisablesCache() {
+    Cache cache(0);
+    cache.Put(1, 10);
+    CHECK(!cache.Get(1));
+    const cache::CacheStats stats = cache.GetStats();
+    CHECK(stats.hits == 0);
+    CHECK(stats.misses == 1);
+    CHECK(stats.size == 0);
+}
+
+}  // namespace
+
+int main() {
+    TestEvictsLeastRecentlyUsed();
+    TestShardsEvictIndependently();
+    TestZeroCapacityDisablesCache();
+    std::cout << "lru_cache_test: OK" << std::endl;
+}
@@ -0,0 +1,359 @@
+// Все движки маршрутизации на обеих моделях графа, с пешими переходами и
+// без, против независимой Дейкстры по остановкам на случайном каталоге;
+// RAPTOR с минимумом пересадок — против раундового эталона.
+//
+// Сборка из каталога transport-catalogue:
+//   g++ -std=c++17 -O2 -pthread -I. tests/router_engines_test.cpp transport_router.cpp raptor_router.cpp router_storage.cpp transport_catalogue.cpp geo.cpp -o router_engines_test
+//   ./router_engines_test
+
+#include "check.h"
+#include "transport_catalogue.h"
+#include "transport_router.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <functional>
+#include <iostream>
+#include <limits>
+#include <optional>
+#include <queue>
+#include <random>
+#include <string>
+#include <utility>
+#include <variant>
+#include <vector>
+
+namespace {
+
+using transport_catalogue::StopId;
+using transport_catalogue::TransportCatalogue;
+
+constexpr size_t STOP_COUNT = 60;
+constexpr size_t BUS_COUNT = 14;
+constexpr double WALK_RADIUS = 400.0;
+constexpr double WALK_VELOCITY = 4.0;
+const transport::RoutingProfile DEFAULT_PROFILE{6, 40.0};
+const transport::RoutingProfile PEAK_PROFILE{11, 17.5};
+
+// Остановки в квадрате около 3 x 3 км, чтобы часть из них оказалась
+// в пешей доступности друг от друга
+void FillCatalogue(TransportCatalogue& catalogue, std::mt19937& random_engine) {
+    std::uniform_real_distribution<double> offset_distribution(0.0, 0.027);
+    for (size_t i = 0; i < STOP_COUNT; ++i) {
+        catalogue.AddStop("Stop " + std::to_string(i),
+                          {55.6 + offset_distribution(random_engine), 37.5 + offset_distribution(random_engine)});
+    }
+    std::uniform_int_distribution<size_t> stop_distribution(0, STOP_COUNT - 1);
+    std::uniform_int_distribution<size_t> length_distribution(2, 9);
+    std::uniform_int_distribution<int> distance_distribution(300, 3000);
+    std::bernoulli_distribution coin(0.5);
+    for (size_t bus = 0; bus < BUS_COUNT; ++bus) {
+        std::vector<StopId> stops;
+        const size_t length = length_distribution(random_engine);
+        while (stops.size() < length) {
+            const StopId stop = static_cast<StopId>(stop_distribution(random_engine));
+            if (stops.empty() || stops.back() != stop) {
+                stops.push_back(stop);
+            }
+        }
+        const bool is_round_trip = coin(random_engine);
+        if (is_round_trip) {
+            stops.push_back(stops.front());
+        }
+        for (size_t k = 0; k + 1 < stops.size(); ++k) {
+            catalogue.SetDistance(stops[k], stops[k + 1], distance_distribution(random_engine));
+            // Обратное расстояние задано не всегда: тогда берётся прямое
+            if (coin(random_engine)) {
+                catalogue.SetDistance(stops[k + 1], stops[k], distance_distribution(random_engine));
+            }
+        }
+        catalogue.AddBus("Bus " + std::to_string(bus), stops, is_round_trip);
+    }
+    catalogue.Freeze();
+    catalogue.PrepareStopIndex();
+}
+
+using OracleAdjacency = std::vector<std::vector<std::pair<StopId, double>>>;
+
+// Граф эталона: вершина — остановка до ожидания, поездка между любыми двумя
+// остановками маршрута (одна поездка) стоит ожидания плюс езды
+OracleAdjacency BuildOracleAdjacency(const TransportCatalogue& catalogue, const transport::RoutingProfile& profile,
+                                     double walk_radius) {
+    const size_t stop_count = catalogue.GetAllStops().size();
+    OracleAdjacency adjacency(stop_count);
+    const double meters_per_minute = profile.bus_velocity * 1000.0 / 60.0;
+    for (const auto& bus : catalogue.GetAllBuses()) {
+        const auto& stops = bus.stops;
+        for (size_t i = 0; i < stops.size(); ++i) {
+            int forward = 0;
+            int backward = 0;
+            for (size_t j = i + 1; j < stops.size(); ++j) {
+                forward += catalogue.GetDistance(stops[j - 1], stops[j]);
+                backward += catalogue.GetDistance(stops[j], stops[j - 1]);
+                adjacency[stops[i]].emplace_back(stops[j], profile.bus_wait_time + forward / meters_per_minute);
+                if (!bus.is_round_trip) {
+                    adjacency[stops[j]].emplace_back(stops[i], profile.bus_wait_time + backward / meters_per_minute);
+                }
+            }
+        }
+    }
+    const auto& all_stops = catalogue.GetAllStops();
+    for (StopId a = 0; a < stop_count; ++a) {
+        for (StopId b = 0; b < stop_count; ++b) {
+            const double distance = geo::ComputeDistance(all_stops[a].coordinates, all_stops[b].coordinates);
+            if (a != b && distance <= walk_radius) {
+                adjacency[a].emplace_back(b, distance / (WALK_VELOCITY * 1000.0 / 60.0));
+            }
+        }
+    }
+    return adjacency;
+}
+
+// Время в пути из from во все остановки
+std::vector<double> ComputeOracleTimes(const TransportCatalogue& catalogue, StopId from,
+                                       const transport::RoutingProfile& profile, double walk_radius) {
+    const OracleAdjacency adjacency = BuildOracleAdjacency(catalogue, profile, walk_radius);
+    std::vector<double> times(adjacency.size(), std::numeric_limits<double>::infinity());
+    using QueueItem = std::pair<double, StopId>;
+    std::priority_queue<QueueItem, std::vector<QueueItem>, std::greater<QueueItem>> queue;
+    times[from] = 0.0;
+    queue.emplace(0.0, from);
+    while (!queue.empty()) {
+        const auto [time, stop] = queue.top();
+        queue.pop();
+        if (time > times[stop]) {
+            continue;
+        }
+        for (const auto& [next, edge_time] : adjacency[stop]) {
+            if (time + edge_time < times[next]) {
+                times[next] = time + edge_time;
+                queue.emplace(times[next], next);
+            }
+        }
+    }
+    return times;
+}
+
+// Для маршрутов с минимумом поездок: минимальное число поездок из from
+// в каждую остановку и лучшее время среди маршрутов с таким числом поездок.
+// Раунд k — лучшие времена не более чем за k поездок.
+struct FewestRides {
+    std::vector<size_t> rides;
+    std::vector<double> times;
+};
+
+FewestRides ComputeOracleFewestRides(const TransportCatalogue& catalogue, StopId from,
+                                     const transport::RoutingProfile& profile) {
+    const OracleAdjacency adjacency = BuildOracleAdjacency(catalogue, profile, 0.0);
+    const size_t stop_count = adjacency.size();
+    FewestRides result{std::vector<size_t>(stop_count, 0),
+                       std::vector<double>(stop_count, std::numeric_limits<double>::infinity())};
+    std::vector<double> times(stop_count, std::numeric_limits<double>::infinity());
+    times[from] = 0.0;
+    for (size_t round = 1; round <= stop_count; ++round) {
+        std::vector<double> next_times = times;
+        for (StopId stop = 0; stop < stop_count; ++stop) {
+            if (std::isinf(times[stop])) {
+                continue;
+            }
+            for (const auto& [next, edge_time] : adjacency[stop]) {
+                next_times[next] = std::min(next_times[next], times[stop] + edge_time);
+            }
+        }
+        times = std::move(next_times);
+        for (StopId stop = 0; stop < stop_count; ++stop) {
+            if (stop != from && std::isinf(result.times[stop]) && !std::isinf(times[stop])) {
+                result.rides[stop] = round;
+                result.times[stop] = times[stop];
+            }
+        }
+    }
+    return result;
+}
+
+bool IsClose(double lhs, double rhs) {
+    return std::abs(lhs - rhs) <= 1e-6 * std::max(1.0, std::abs(rhs));
+}
+
+double SumItemTimes(const transport::RouteInfo& route) {
+    double total = 0.0;
+    for (const auto& item : route.items) {
+        total += std::visit([](const auto& concrete_item) {
+            return concrete_item.time;
+        }, item);
+    }
+    return total;
+}
+
+size_t CountBusItems(const transport::RouteInfo& route) {
+    return std::count_if(route.items.begin(), route.items.end(), [](const auto& item) {
+        return std::holds_alternative<transport::BusItem>(item);
+    });
+}
+
+// Быстрее с пересадкой (A -> B -> C за 8 минут), чем без неё: прямой
+// автобус A -> C идёт 22 минуты, кружной через D — 26
+void TestFewestTransfersDiffersFromFastest() {
+    TransportCatalogue catalogue;
+    const StopId a = catalogue.AddStop("A", {55.60, 37.50});
+    const StopId b = catalogue.AddStop("B", {55.61, 37.50});
+    const StopId c = catalogue.AddStop("C", {55.62, 37.50});
+    const StopId d = catalogue.AddStop("D", {55.63, 37.50});
+    catalogue.SetDistance(a, b, 1000);
+    catalogue.SetDistance(b, c, 1000);
+    catalogue.SetDistance(a, c, 10000);
+    catalogue.SetDistance(a, d, 6000);
+    catalogue.SetDistance(d, c, 6000);
+    catalogue.AddBus("Direct", {a, c}, false);
+    catalogue.AddBus("Long", {a, d, c}, false);
+    catalogue.AddBus("First", {a, b}, false);
+    catalogue.AddBus("Second", {b, c}, false);
+    catalogue.Freeze();
+
+    transport::RouterSettings settings;
+    settings.bus_wait_time = 2;
+    settings.bus_velocity = 30.0;
+    settings.engine = transport::RouterEngine::RAPTOR;
+    const transport::Router fastest_router(settings, catalogue);
+    settings.fewest_transfers = true;
+    const transport::Router fewest_router(settings, catalogue);
+
+    const auto fastest = fastest_router.GetRouteInfo(a, c);
+    const auto fewest = fewest_router.GetRouteInfo(a, c);
+    CHECK(fastest && fewest);
+    CHECK(CountBusItems(*fastest) == 2);
+    CHECK(IsClose(fastest->total_time, 8.0));
+    CHECK(CountBusItems(*fewest) == 1);
+    CHECK(IsClose(fewest->total_time, 22.0));
+    CHECK(std::get<transport::BusItem>(fewest->items[1]).bus_id == catalogue.FindBus("Direct")->id);
+    CHECK(IsClose(SumItemTimes(*fewest), fewest->total_time));
+}
+
+// RAPTOR с минимумом пересадок против раундового эталона на всех парах
+size_t CheckFewestTransfers(const TransportCatalogue& catalogue) {
+    transport::RouterSettings settings;
+    settings.bus_wait_time = DEFAULT_PROFILE.bus_wait_time;
+    settings.bus_velocity = DEFAULT_PROFILE.bus_velocity;
+    settings.engine = transport::RouterEngine::RAPTOR;
+    settings.fewest_transfers = true;
+    const transport::Router router(settings, catalogue);
+
+    const size_t stop_count = catalogue.GetAllStops().size();
+    size_t checked_routes = 0;
+    size_t differs_from_fastest = 0;
+    for (StopId from = 0; from < stop_count; ++from) {
+        const FewestRides expected = ComputeOracleFewestRides(catalogue, from, DEFAULT_PROFILE);
+        const std::vector<double> fastest_times = ComputeOracleTimes(catalogue, from, DEFAULT_PROFILE, 0.0);
+        for (StopId to = 0; to < stop_count; ++to) {
+            if (from == to) {
+                continue;
+            }
+            const auto route = router.GetRouteInfo(from, to);
+            CHECK(std::isinf(expected.times[to]) == !route.has_value());
+            if (route) {
+                CHECK(CountBusItems(*route) == expected.rides[to]);
+                CHECK(IsClose(route->total_time, expected.times[to]));
+                CHECK(IsClose(SumItemTimes(*route), route->total_time));
+                differs_from_fastest += !IsClose(route->total_time, fastest_times[to]);
+            }
+            ++checked_routes;
+        }
+    }
+    // Иначе проверка не отличила бы этот режим от минимума времени
+    CHECK(differs_from_fastest > 0);
+    return checked_routes;
+}
+
+struct EngineCase {
+    const char* name;
+    transport::RouterEngine engine;
+};
+
+}  // namespace
+
+int main() {
+    std::mt19937 random_engine(2024);
+    TransportCatalogue catalogue;
+    FillCatalogue(catalogue, random_engine);
+    const size_t stop_count = catalogue.GetAllStops().size();
+
+    const EngineCase engines[] = {
+        {"all_pairs", transport::RouterEngine::ALL_PAIRS},
+        {"dijkstra", transport::RouterEngine::DIJKSTRA},
+        {"contraction_hierarchies", transport::RouterEngine::CONTRACTION_HIERARCHIES},
+        {"blocked_all_pairs", transport::RouterEngine::BLOCKED_ALL_PAIRS},
+        {"compact_all_pairs", transport::RouterEngine::COMPACT_ALL_PAIRS},
+        {"raptor", transport::RouterEngine::RAPTOR},
+        {"alt", transport::RouterEngine::ALT},
+        {"bidirectional_dijkstra", transport::RouterEngine::BIDIRECTIONAL_DIJKSTRA},
+    };
+    const transport::GraphModel models[] = {transport::GraphModel::STOP_PAIRS, transport::GraphModel::ROUTE_PATTERNS};
+    const std::pair<const char*, transport::RoutingProfile> profiles[] = {{"", DEFAULT_PROFILE},
+                                                                         {"peak", PEAK_PROFILE}};
+
+    // Эталон не зависит от движка: считается один раз на профиль и радиус
+    std::vector<std::vector<std::vector<double>>> oracle_times[2];
+    for (size_t walk = 0; walk < 2; ++walk) {
+        for (const auto& [name, profile] : profiles) {
+            auto& times = oracle_times[walk].emplace_back();
+            for (StopId from = 0; from < stop_count; ++from) {
+                times.push_back(ComputeOracleTimes(catalogue, from, profile, walk == 1 ? WALK_RADIUS : 0.0));
+            }
+        }
+    }
+
+    size_t checked_routes = 0;
+    for (const auto& [engine_name, engine] : engines) {
+        for (const auto model : models) {
+            for (size_t walk = 0; walk < 2; ++walk) {
+                // RAPTOR не строит граф и не учитывает пешие переходы
+                if (engine == transport::RouterEngine::RAPTOR
+                    && (model != transport::GraphModel::STOP_PAIRS || walk == 1)) {
+                    continue;
+                }
+                transport::RouterSettings settings;
+                settings.bus_wait_time = DEFAULT_PROFILE.bus_wait_time;
+                settings.bus_velocity = DEFAULT_PROFILE.bus_velocity;
+                settings.engine = engine;
+                settings.graph_model = model;
+                settings.walk_radius = walk == 1 ? WALK_RADIUS : 0.0;
+                settings.walk_velocity = WALK_VELOCITY;
+                transport::Router router(settings, catalogue);
+                router.SetProfile("peak", PEAK_PROFILE);
+
+                for (size_t profile_index = 0; profile_index < 2; ++profile_index) {
+                    const auto& times = oracle_times[walk][profile_index];
+                    for (StopId from = 0; from < stop_count; ++from) {
+                        for (StopId to = 0; to < stop_count; ++to) {
+                            if (from == to) {
+                                continue;
+                            }
+                            const auto route = router.GetRouteInfo(from, to, profiles[profile_index].first);
+                            const double expected = times[from][to];
+                            if (std::isinf(expected) != !route.has_value()
+                                || (route && (!IsClose(route->total_time, expected)
+                                              || !IsClose(SumItemTimes(*route), route->total_time)))) {
+                                std::cerr << engine_name << ", model " << static_cast<int>(model)
+                                          << ", walk " << walk << ", profile '" << profiles[profile_index].first
+                                          << "': " << from << " -> " << to << " expected " << expected
+                                          << ", got " << (route ? route->total_time : -1.0) << std::endl;
+                            }
+                            CHECK(std::isinf(expected) == !route.has_value());
+                            if (route) {
+                                CHECK(IsClose(route->total_time, expected));
+                                CHECK(IsClose(SumItemTimes(*route), route->total_time));
+                            }
+                            ++checked_routes;
+                        }
+                    }
+                }
+            }
+        }
+    }
+    TestFewestTransfersDiffersFromFastest();
+    checked_routes += CheckFewestTransfers(catalogue);
+
+    std::cout << "checked routes: " << checked_routes << "\n"
+              << "router_engines_test: OK" << std::endl;
+}
@@ -0,0 +1,217 @@
+// Файл состояния роутера (state_file) для BLOCKED_ALL_PAIRS и
+// COMPACT_ALL_PAIRS: сохранение, загрузка с теми же ответами, перезапись
+// при другом ключе и откат к пересчёту при повреждённом файле.
+//
+// Сборка из каталога transport-catalogue:
+//   g++ -std=c++17 -O2 -pthread -I. tests/router_state_test.cpp transport_router.cpp raptor_router.cpp router_storage.cpp transport_catalogue.cpp geo.cpp -o router_state_test
+//   ./router_state_test
+
+#include "check.h"
+#include "transport_catalogue.h"
+#include "transport_router.h"
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+
+using transport_catalogue::StopId;
+using transport_catalogue::TransportCatalogue;
+
+constexpr size_t STOP_COUNT = 40;
+constexpr size_t BUS_COUNT = 10;
+constexpr uint64_t STATE_KEY = 0x5EED;
+
+void FillCatalogue(TransportCatalogue& catalogue) {
+    std::mt19937 random_engine(11);
+    std::uniform_real_distribution<double> offset_distribution(0.0, 0.03);
+    for (size_t i = 0; i < STOP_COUNT; ++i) {
+        catalogue.AddStop("Stop " + std::to_string(i),
+                          {55.6 + offset_distribution(random_engine), 37.5 + offset_distribution(random_engine)});
+    }
+    std::uniform_int_distribution<size_t> stop_distribution(0, STOP_COUNT - 1);
+    std::uniform_int_distribution<int> distance_distribution(300, 3000);
+    for (size_t bus = 0; bus < BUS_COUNT; ++bus) {
+        std::vector<StopId> stops;
+        while (stops.size() < 6) {
+            const StopId stop = static_cast<StopId>(stop_distribution(random_engine));
+            if (stops.empty() || stops.back() != stop) {
+                stops.push_back(stop);
+            }
+        }
+        for (size_t k = 0; k + 1 < stops.size(); ++k) {
+            catalogue.SetDistance(stops[k], stops[k + 1], distance_distribution(random_engine));
+        }
+        catalogue.AddBus("Bus " + std::to_string(bus), stops, bus % 2 == 0);
+    }
+    catalogue.Freeze();
+    catalogue.PrepareStopIndex();
+}
+
+transport::RouterSettings MakeSettings(transport::RouterEngine engine, const std::string& state_file, uint64_t key) {
+    transport::RouterSettings settings;
+    settings.bus_wait_time = 6;
+    settings.bus_velocity = 40.0;
+    settings.engine = engine;
+    settings.walk_radius = 300.0;
+    settings.state_file = state_file;
+    settings.state_key = key;
+    return settings;
+}
+
+// Ответы роутера совпадают с ответами роутера без файла состояния
+void CheckSameRoutes(const transport::Router& router, const transport::Router& reference) {
+    for (StopId from = 0; from < STOP_COUNT; ++from) {
+        for (StopId to = 0; to < STOP_COUNT; ++to) {
+            const auto route = router.GetRouteInfo(from, to);
+            const auto expected = reference.GetRouteInfo(from, to);
+            CHECK(route.has_value() == expected.has_value());
+            if (route) {
+                CHECK(route->total_time == expected->total_time);
+                CHECK(route->items.size() == expected->items.size());
+            }
+        }
+    }
+}
+
+std::vector<char> ReadFile(const std::string& path) {
+    std::ifstream input(path, std::ios::binary);
+    return {std::istreambuf_iterator<char>(input), std::istreambuf_iterator<char>()};
+}
+
+void WriteFile(const std::string& path, const std::vector<char>& data) {
+    std::ofstream output(path, std::ios::binary | std::ios::trunc);
+    output.write(data.data(), static_cast<std::streamsize>(data.size()));
+}
+
+void TestEngine(const TransportCatalogue& catalogue, transport::RouterEngine engine, const std::string& path) {
+    std::filesystem::remove(path);
+    const transport::Router reference(MakeSettings(engine, {}, 0), catalogue);
+
+    // Первый запуск считает таблицу и сохраняет её
+    {
+        const transport::Router router(MakeSettings(engine, path, STATE_KEY), catalogue);
+        CHECK(std::filesystem::exists(path));
+        CheckSameRoutes(router, reference);
+    }
+    const std::vector<char> saved = ReadFile(path);
+    CHECK(!saved.empty());
+
+    // Второй запуск отображает тот же файл и не переписывает его
+    {
+        const transport::Router router(MakeSettings(engine, path, STATE_KEY), catalogue);
+        CheckSameRoutes(router, reference);
+    }
+    CHECK(ReadFile(path) == saved);
+
+    // Повреждения: обрезанный файл, старая версия, секция поверх рёбер, маршрут
+    // не из каталога у ребра и испорченные таблицы путей (их содержимое
+    // проверяется при загрузке)
+    std::vector<std::vector<char>> corrupted_files;
+    corrupted_files.emplace_back(saved.begin(), saved.begin() + saved.size() / 2);
+    // По раскладке router_storage.cpp: число рёбер — по смещению 40
+    // в 56-байтном заголовке, за ним рёбра по 32 байта (name_id в начале,
+    // to по смещению 16) и таблица секций {offset, size}
+    uint64_t edge_count = 0;
+    std::memcpy(&edge_count, saved.data() + 40, sizeof(edge_count));
+    const size_t section_table = 56 + edge_count * 32;
+    {
+        auto overlapping = saved;
+        const uint64_t bad_offset = 64;
+        std::memcpy(overlapping.data() + section_table, &bad_offset, sizeof(bad_offset));
+        corrupted_files.push_back(std::move(overlapping));
+    }
+    {
+        // Файл прежней версии формата (format_version по смещению 8):
+        // в нём другие веса рёбер и нумерация вершин
+        auto old_version = saved;
+        const uint32_t format_version = 1;
+        std::memcpy(old_version.data() + 8, &format_version, sizeof(format_version));
+        corrupted_files.push_back(std::move(old_version));
+    }
+    {
+        auto bad_name = saved;
+        const uint32_t name_id = 1000000;
+        std::memcpy(bad_name.data() + 56, &name_id, sizeof(name_id));
+        corrupted_files.push_back(std::move(bad_name));
+    }
+    // Последние рёбра путей: у блочного роутера во второй секции по 8 байт
+    // со стороной, дополненной до 64, у компактного — в единственной по 4
+    const bool is_blocked = engine == transport::RouterEngine::BLOCKED_ALL_PAIRS;
+    uint64_t table_offset = 0;
+    uint64_t table_size = 0;
+    std::memcpy(&table_offset, saved.data() + section_table + (is_blocked ? 16 : 0), sizeof(table_offset));
+    std::memcpy(&table_size, saved.data() + section_table + (is_blocked ? 24 : 8), sizeof(table_size));
+    const size_t cell_size = is_blocked ? 8 : 4;
+    const size_t dimension = static_cast<size_t>(std::sqrt(static_cast<double>(table_size / cell_size)) + 0.5);
+    const auto write_cell = [&](std::vector<char>& file, size_t from, size_t to, uint64_t edge_id) {
+        std::memcpy(file.data() + table_offset + (from * dimension + to) * cell_size, &edge_id, cell_size);
+    };
+    const auto read_cell = [&](size_t from, size_t to) {
+        uint64_t edge_id = 0;
+        std::memcpy(&edge_id, saved.data() + table_offset + (from * dimension + to) * cell_size, cell_size);
+        return edge_id;
+    };
+    const uint64_t no_edge = is_blocked ? ~uint64_t{0} : uint32_t(~0u);
+    {
+        // Ребро за пределами таблицы рёбер
+        auto out_of_range = saved;
+        write_cell(out_of_range, 0, 1, 123456789);
+        corrupted_files.push_back(std::move(out_of_range));
+    }
+    {
+        // Путь из вершины в неё саму через существующее ребро: цепочка
+        // в пределах таблицы, но не приходит в начало
+        uint32_t edge_to = 0;
+        std::memcpy(&edge_to, saved.data() + 56 + 16, sizeof(edge_to));
+        auto cycle = saved;
+        CHECK(read_cell(edge_to, edge_to) == no_edge);
+        write_cell(cycle, edge_to, edge_to, 0);
+        corrupted_files.push_back(std::move(cycle));
+    }
+    if (!is_blocked) {
+        auto garbage = saved;
+        for (size_t i = garbage.size() - 4096; i < garbage.size(); ++i) {
+            garbage[i] = static_cast<char>(0x5A);
+        }
+        corrupted_files.push_back(std::move(garbage));
+    }
+    for (const auto& corrupted : corrupted_files) {
+        WriteFile(path, corrupted);
+        {
+            const transport::Router router(MakeSettings(engine, path, STATE_KEY), catalogue);
+            CheckSameRoutes(router, reference);
+        }
+        // Файл отвергнут: таблица посчитана заново и сохранена
+        CHECK(ReadFile(path) == saved);
+    }
+
+    // Файл для других данных не используется и перезаписывается
+    WriteFile(path, saved);
+    {
+        const transport::Router router(MakeSettings(engine, path, STATE_KEY + 1), catalogue);
+        CheckSameRoutes(router, reference);
+    }
+    CHECK(ReadFile(path) != saved);
+    std::filesystem::remove(path);
+}
+
+}  // namespace
+
+int main() {
+    TransportCatalogue catalogue;
+    FillCatalogue(catalogue);
+    const std::string path = (std::filesystem::temp_directory_path() / "router_state_test.bin").string();
+    TestEngine(catalogue, transport::RouterEngine::BLOCKED_ALL_PAIRS, path);
+    TestEngine(catalogue, transport::RouterEngine::COMPACT_ALL_PAIRS, path);
+    std::cout << "router_state_test: OK" << std::endl;
+}
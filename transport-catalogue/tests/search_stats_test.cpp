@@ -0,0 +1,91 @@
+// Двунаправленная Дейкстра и ALT против DijkstraRouter на одних и тех же
+// запросах по сетке: одинаковые веса маршрутов и число просмотренных
+// вершин по GetSearchStats.
+//
+// Сборка из каталога transport-catalogue:
+//   g++ -std=c++17 -O2 -pthread -I. tests/search_stats_test.cpp -o search_stats_test && ./search_stats_test
+
+#include "alt_router.h"
+#include "bidirectional_router.h"
+#include "check.h"
+#include "dijkstra_router.h"
+
+#include <cmath>
+#include <cstddef>
+#include <iostream>
+#include <random>
+
+namespace {
+
+constexpr size_t GRID_SIDE = 60;
+constexpr size_t QUERY_COUNT = 500;
+
+// Сетка GRID_SIDE x GRID_SIDE с рёбрами в обе стороны между соседями
+graph::DirectedWeightedGraph<double> MakeGrid(std::mt19937& random_engine) {
+    std::uniform_real_distribution<double> weight_distribution(1.0, 2.0);
+    graph::DirectedWeightedGraph<double> grid(GRID_SIDE * GRID_SIDE);
+    const auto add_both_ways = [&](graph::VertexId from, graph::VertexId to) {
+        grid.AddEdge({0, 1, from, to, weight_distribution(random_engine)});
+        grid.AddEdge({0, 1, to, from, weight_distribution(random_engine)});
+    };
+    for (size_t row = 0; row < GRID_SIDE; ++row) {
+        for (size_t col = 0; col < GRID_SIDE; ++col) {
+            const graph::VertexId vertex = row * GRID_SIDE + col;
+            if (col + 1 < GRID_SIDE) {
+                add_both_ways(vertex, vertex + 1);
+            }
+            if (row + 1 < GRID_SIDE) {
+                add_both_ways(vertex, vertex + GRID_SIDE);
+            }
+        }
+    }
+    grid.Freeze();
+    return grid;
+}
+
+}  // namespace
+
+int main() {
+    std::mt19937 random_engine(7);
+    const auto grid = MakeGrid(random_engine);
+    const graph::DijkstraRouter<double> dijkstra(grid);
+    const graph::BidirectionalDijkstraRouter<double> bidirectional(grid);
+    const graph::AltRouter<double> alt(grid);
+
+    std::uniform_int_distribution<graph::VertexId> vertex_distribution(0, grid.GetVertexCount() - 1);
+    for (size_t i = 0; i < QUERY_COUNT; ++i) {
+        const graph::VertexId from = vertex_distribution(random_engine);
+        const graph::VertexId to = vertex_distribution(random_engine);
+        const auto expected = dijkstra.BuildRoute(from, to);
+        CHECK(expected);
+        for (const auto& actual : {bidirectional.BuildRoute(from, to), alt.BuildRoute(from, to)}) {
+            CHECK(actual);
+            CHECK(std::abs(expected->weight - actual->weight) < 1e-9);
+            double edges_weight = 0.0;
+            for (const graph::EdgeId edge_id : actual->edges) {
+                edges_weight += grid.GetEdge(edge_id).weight;
+            }
+            CHECK(std::abs(edges_weight - actual->weight) < 1e-9);
+        }
+    }
+
+    const graph::SearchStats dijkstra_stats = dijkstra.GetSearchStats();
+    const graph::SearchStats bidirectional_stats = bidirectional.GetSearchStats();
+    const graph::SearchStats alt_stats = alt.GetSearchStats();
+    CHECK(dijkstra_stats.queries == QUERY_COUNT);
+    CHECK(bidirectional_stats.queries == QUERY_COUNT);
+    CHECK(alt_stats.queries == QUERY_COUNT);
+    CHECK(bidirectional_stats.settled_vertices < dijkstra_stats.settled_vertices);
+    CHECK(alt_stats.settled_vertices < dijkstra_stats.settled_vertices);
+
+    const auto print = [&](const char* name, const graph::SearchStats& stats) {
+        std::cout << name << ": " << static_cast<double>(stats.settled_vertices) / QUERY_COUNT
+                  << " settled vertices per query, "
+                  << static_cast<double>(stats.settled_vertices) / dijkstra_stats.settled_vertices
+                  << " of dijkstra\n";
+    };
+    print("dijkstra", dijkstra_stats);
+    print("bidirectional", bidirectional_stats);
+    print("alt", alt_stats);
+    std::cout << "search_stats_test: OK" << std::endl;
+}
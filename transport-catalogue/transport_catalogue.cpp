@@ -1,158 +1,570 @@
 #include "transport_catalogue.h"
+#include "parallel.h"
 #include <chrono>
 #include <iostream>
+#include <algorithm>
 #include <cmath> // Для std::round
+#include <numeric>
+#include <stdexcept>
 
 namespace transport_catalogue {
 
-void TransportCatalogue::AddStop(const std::string& name, const geo::Coordinates& coordinates) {
+namespace {
+
+// Финализатор splitmix64: каждый бит ключа влияет на все биты хеша
+uint64_t Mix(uint64_t key) {
+    key ^= key >> 30;
+    key *= 0xBF58476D1CE4E5B9ull;
+    key ^= key >> 27;
+    key *= 0x94D049BB133111EBull;
+    key ^= key >> 31;
+    return key;
+}
+
+} // namespace
+
+size_t DistanceTable::FindSlot(uint64_t key) const {
+    const size_t mask = slots_.size() - 1;
+    size_t index = Mix(key) & mask;
+    while (slots_[index].key != key && slots_[index].key != EMPTY_KEY) {
+        index = (index + 1) & mask;
+    }
+    return index;
+}
+
+void DistanceTable::Rehash(size_t capacity) {
+    std::vector<Slot> old_slots = std::move(slots_);
+    slots_.assign(capacity, Slot{});
+    for (const Slot& slot : old_slots) {
+        if (slot.key != EMPTY_KEY) {
+            slots_[FindSlot(slot.key)] = slot;
+        }
+    }
+}
+
+void DistanceTable::Set(StopId from, StopId to, int distance) {
+    if ((size_ + 1) * 2 > slots_.size()) {
+        Rehash(std::max<size_t>(16, slots_.size() * 2));
+    }
+    const uint64_t key = MakeKey(from, to);
+    Slot& slot = slots_[FindSlot(key)];
+    if (slot.key == EMPTY_KEY) {
+        slot.key = key;
+        ++size_;
+    }
+    slot.distance = distance;
+}
+
+const int* DistanceTable::Find(StopId from, StopId to) const {
+    if (slots_.empty()) {
+        return nullptr;
+    }
+    const Slot& slot = slots_[FindSlot(MakeKey(from, to))];
+    return slot.key == EMPTY_KEY ? nullptr : &slot.distance;
+}
+
+uint64_t PerfectHash::HashName(std::string_view name) {
+    return Mix(std::hash<std::string_view>{}(name));
+}
+
+size_t PerfectHash::GetSlot(uint64_t hash, uint32_t seed) const {
+    return Mix(hash + seed * 0x9E3779B97F4A7C15ull) % ids_.size();
+}
+
+bool PerfectHash::Build(const std::vector<std::pair<std::string_view, uint32_t>>& keys) {
+    const size_t key_count = keys.size();
+    const size_t bucket_count = key_count / KEYS_PER_BUCKET + 1;
+    std::vector<uint64_t> hashes(key_count);
+    std::vector<std::vector<size_t>> buckets(bucket_count);
+    for (size_t key = 0; key < key_count; ++key) {
+        hashes[key] = HashName(keys[key].first);
+        buckets[hashes[key] % bucket_count].push_back(key);
+    }
+    // Большие корзины размещаются первыми, пока свободных ячеек много
+    std::vector<size_t> bucket_order(bucket_count);
+    std::iota(bucket_order.begin(), bucket_order.end(), size_t{0});
+    std::stable_sort(bucket_order.begin(), bucket_order.end(), [&buckets](size_t lhs, size_t rhs) {
+        return buckets[lhs].size() > buckets[rhs].size();
+    });
+
+    seeds_.assign(bucket_count, 0);
+    ids_.assign(key_count, NO_ID);
+    std::vector<size_t> slots;
+    for (const size_t bucket : bucket_order) {
+        if (buckets[bucket].empty()) {
+            break;
+        }
+        bool is_placed = false;
+        for (uint32_t seed = 0; seed < MAX_SEED && !is_placed; ++seed) {
+            slots.clear();
+            for (const size_t key : buckets[bucket]) {
+                const size_t slot = GetSlot(hashes[key], seed);
+                if (ids_[slot] != NO_ID || std::find(slots.begin(), slots.end(), slot) != slots.end()) {
+                    break;
+                }
+                slots.push_back(slot);
+            }
+            if (slots.size() == buckets[bucket].size()) {
+                for (size_t k = 0; k < slots.size(); ++k) {
+                    ids_[slots[k]] = keys[buckets[bucket][k]].second;
+                }
+                seeds_[bucket] = seed;
+                is_placed = true;
+            }
+        }
+        if (!is_placed) {
+            // Например, у двух названий совпал 64-битный хеш
+            seeds_.clear();
+            ids_.clear();
+            return false;
+        }
+    }
+    return true;
+}
+
+uint32_t PerfectHash::Find(std::string_view name) const {
+    if (ids_.empty()) {
+        return NO_ID;
+    }
+    const uint64_t hash = HashName(name);
+    return ids_[GetSlot(hash, seeds_[hash % seeds_.size()])];
+}
+
+namespace {
+
+double GetAxis(const geo::UnitVector& point, int axis) {
+    return axis == 0 ? point.x : axis == 1 ? point.y : point.z;
+}
+
+double SquaredChord(const geo::UnitVector& from, const geo::UnitVector& to) {
+    const double dx = from.x - to.x;
+    const double dy = from.y - to.y;
+    const double dz = from.z - to.z;
+    return dx * dx + dy * dy + dz * dz;
+}
+
+// Произведение отрезков [a_min, a_max] * [b_min, b_max] при a_min >= 0
+std::pair<double, double> MultiplyRanges(double a_min, double a_max, double b_min, double b_max) {
+    return {b_min >= 0.0 ? a_min * b_min : a_max * b_min, b_max >= 0.0 ? a_max * b_max : a_min * b_max};
+}
+
+} // namespace
+
+void StopIndex::Build(const std::vector<Stop>& stops) {
+    nodes_.clear();
+    nodes_.reserve(stops.size());
+    for (const Stop& stop : stops) {
+        nodes_.push_back({stop.position, stop.coordinates, stop.id, 0});
+    }
+    BuildRange(0, nodes_.size());
+}
+
+void StopIndex::BuildRange(size_t begin, size_t end) {
+    if (end - begin <= 1) {
+        return;
+    }
+    // Делим по оси с наибольшим разбросом точек
+    double min[3] = {1.0, 1.0, 1.0};
+    double max[3] = {-1.0, -1.0, -1.0};
+    for (size_t i = begin; i < end; ++i) {
+        for (int axis = 0; axis < 3; ++axis) {
+            min[axis] = std::min(min[axis], GetAxis(nodes_[i].position, axis));
+            max[axis] = std::max(max[axis], GetAxis(nodes_[i].position, axis));
+        }
+    }
+    int axis = 0;
+    for (int candidate = 1; candidate < 3; ++candidate) {
+        if (max[candidate] - min[candidate] > max[axis] - min[axis]) {
+            axis = candidate;
+        }
+    }
+
+    const size_t middle = begin + (end - begin) / 2;
+    std::nth_element(nodes_.begin() + begin, nodes_.begin() + middle, nodes_.begin() + end,
+                     [axis](const Node& lhs, const Node& rhs) {
+                         return GetAxis(lhs.position, axis) < GetAxis(rhs.position, axis);
+                     });
+    nodes_[middle].axis = static_cast<uint8_t>(axis);
+    BuildRange(begin, middle);
+    BuildRange(middle + 1, end);
+}
+
+std::vector<StopIndex::NearbyStop> StopIndex::FindNearest(geo::Coordinates point, size_t count) const {
+    const geo::UnitVector position = geo::ToUnitVector(point);
+    // Куча с вершиной в худшем из найденных кандидатов
+    std::vector<Candidate> heap;
+    heap.reserve(std::min(count, nodes_.size()) + 1);
+    if (count > 0) {
+        SearchNearest(0, nodes_.size(), position, count, heap);
+    }
+    std::sort_heap(heap.begin(), heap.end());
+
+    std::vector<NearbyStop> result;
+    result.reserve(heap.size());
+    for (const Candidate& candidate : heap) {
+        // По хорде вычисляется только порядок, расстояние — той же формулой, что в geo
+        result.push_back({candidate.node->id, geo::ComputeDistance(position, candidate.node->position)});
+    }
+    return result;
+}
+
+void StopIndex::SearchNearest(size_t begin, size_t end, const geo::UnitVector& point, size_t count,
+                              std::vector<Candidate>& heap) const {
+    if (begin >= end) {
+        return;
+    }
+    const size_t middle = begin + (end - begin) / 2;
+    const Node& node = nodes_[middle];
+
+    const Candidate candidate{SquaredChord(point, node.position), &node};
+    if (heap.size() < count) {
+        heap.push_back(candidate);
+        std::push_heap(heap.begin(), heap.end());
+    } else if (candidate < heap.front()) {
+        std::pop_heap(heap.begin(), heap.end());
+        heap.back() = candidate;
+        std::push_heap(heap.begin(), heap.end());
+    }
+
+    // Сначала половина, где лежит точка; вторая — только если разделяющая
+    // плоскость ближе худшего кандидата
+    const double offset = GetAxis(point, node.axis) - GetAxis(node.position, node.axis);
+    const bool point_is_left = offset < 0.0;
+    SearchNearest(point_is_left ? begin : middle + 1, point_is_left ? middle : end, point, count, heap);
+    if (heap.size() < count || offset * offset <= heap.front().squared_chord) {
+        SearchNearest(point_is_left ? middle + 1 : begin, point_is_left ? end : middle, point, count, heap);
+    }
+}
+
+std::vector<StopId> StopIndex::FindInArea(geo::Coordinates min, geo::Coordinates max) const {
+    std::vector<StopId> result;
+    if (min.lat > max.lat || min.lng > max.lng) {
+        return result;
+    }
+
+    // Область на сфере вписывается в параллелепипед: z = sin(lat) монотонна,
+    // x = cos(lat) * cos(lng) и y = cos(lat) * sin(lng) оцениваются через
+    // диапазоны сомножителей с учётом экстремумов внутри отрезков
+    const geo::UnitVector lat_min = geo::ToUnitVector({min.lat, 0.0});
+    const geo::UnitVector lat_max = geo::ToUnitVector({max.lat, 0.0});
+    const geo::UnitVector lng_min = geo::ToUnitVector({0.0, min.lng});
+    const geo::UnitVector lng_max = geo::ToUnitVector({0.0, max.lng});
+
+    const double cos_lat_min = std::min(lat_min.x, lat_max.x);
+    const double cos_lat_max = min.lat <= 0.0 && 0.0 <= max.lat ? 1.0 : std::max(lat_min.x, lat_max.x);
+    const double cos_lng_min = min.lng <= -180.0 || max.lng >= 180.0 ? -1.0 : std::min(lng_min.x, lng_max.x);
+    const double cos_lng_max = min.lng <= 0.0 && 0.0 <= max.lng ? 1.0 : std::max(lng_min.x, lng_max.x);
+    const double sin_lng_min = min.lng <= -90.0 && -90.0 <= max.lng ? -1.0 : std::min(lng_min.y, lng_max.y);
+    const double sin_lng_max = min.lng <= 90.0 && 90.0 <= max.lng ? 1.0 : std::max(lng_min.y, lng_max.y);
+
+    const auto [x_min, x_max] = MultiplyRanges(cos_lat_min, cos_lat_max, cos_lng_min, cos_lng_max);
+    const auto [y_min, y_max] = MultiplyRanges(cos_lat_min, cos_lat_max, sin_lng_min, sin_lng_max);
+    // Запас на округление: точное сравнение делается по градусам
+    constexpr double EPSILON = 1e-9;
+    const Box box{{x_min - EPSILON, y_min - EPSILON, lat_min.z - EPSILON},
+                  {x_max + EPSILON, y_max + EPSILON, lat_max.z + EPSILON}};
+
+    SearchArea(0, nodes_.size(), box, min, max, result);
+    std::sort(result.begin(), result.end());
+    return result;
+}
+
+void StopIndex::SearchArea(size_t begin, size_t end, const Box& box, geo::Coordinates min, geo::Coordinates max,
+                           std::vector<StopId>& result) const {
+    if (begin >= end) {
+        return;
+    }
+    const size_t middle = begin + (end - begin) / 2;
+    const Node& node = nodes_[middle];
+    if (min.lat <= node.coordinates.lat && node.coordinates.lat <= max.lat &&
+        min.lng <= node.coordinates.lng && node.coordinates.lng <= max.lng) {
+        result.push_back(node.id);
+    }
+    const double split = GetAxis(node.position, node.axis);
+    if (box.min[node.axis] <= split) {
+        SearchArea(begin, middle, box, min, max, result);
+    }
+    if (box.max[node.axis] >= split) {
+        SearchArea(middle + 1, end, box, min, max, result);
+    }
+}
+
+std::vector<StopIndex::NearbyStop> StopIndex::FindWithinRadius(geo::Coordinates point, double radius) const {
+    std::vector<NearbyStop> result;
+    if (radius < 0.0) {
+        return result;
+    }
+    // Хорда не длиннее дуги, поэтому квадрат угла ограничивает квадрат хорды
+    // сверху; точная проверка — по расстоянию из geo
+    const double angle = radius / geo::EARTH_RADIUS;
+    SearchRadius(0, nodes_.size(), geo::ToUnitVector(point), angle * angle, radius, result);
+    std::sort(result.begin(), result.end(), [](const NearbyStop& lhs, const NearbyStop& rhs) {
+        return lhs.id < rhs.id;
+    });
+    return result;
+}
+
+void StopIndex::SearchRadius(size_t begin, size_t end, const geo::UnitVector& point, double max_squared_chord,
+                             double radius, std::vector<NearbyStop>& result) const {
+    if (begin >= end) {
+        return;
+    }
+    const size_t middle = begin + (end - begin) / 2;
+    const Node& node = nodes_[middle];
+    if (SquaredChord(point, node.position) <= max_squared_chord) {
+        if (const double distance = geo::ComputeDistance(point, node.position); distance <= radius) {
+            result.push_back({node.id, distance});
+        }
+    }
+    const double offset = GetAxis(point, node.axis) - GetAxis(node.position, node.axis);
+    if (offset <= 0.0 || offset * offset <= max_squared_chord) {
+        SearchRadius(begin, middle, point, max_squared_chord, radius, result);
+    }
+    if (offset >= 0.0 || offset * offset <= max_squared_chord) {
+        SearchRadius(middle + 1, end, point, max_squared_chord, radius, result);
+    }
+}
+
+void TransportCatalogue::CheckNotFrozen() const {
+    if (is_frozen_) {
+        throw std::logic_error("Catalogue is frozen");
+    }
+}
+
+void TransportCatalogue::CheckFrozen() const {
+    if (!is_frozen_) {
+        throw std::logic_error("Catalogue is not frozen");
+    }
+}
+
+std::string_view TransportCatalogue::StoreName(const std::string& name) {
+    return name_storage_.emplace_back(name);
+}
+
+StopId TransportCatalogue::AddStop(const std::string& name, const geo::Coordinates& coordinates) {
+    CheckNotFrozen();
+    ++version_;
     // Проверяем, существует ли уже запись в stops_map_
     auto it = stops_map_.find(name);
     if (it != stops_map_.end()) {
-        // Если запись с таким именем уже существует, обновляем соответствующий объект Stop
-        const Stop* existing_stop = it->second; // Получаем указатель на уже существующий объект Stop
-        const_cast<Stop*>(existing_stop)->coordinates = coordinates;
-    } else {
-        // Если записи не существует, добавляем новый объект Stop и обновляем карту
-        stops_.emplace_back(Stop{name, coordinates}); // Добавляем в дек
-        stops_map_[name] = &stops_.back(); // Обновляем мапу, устанавливая ссылку на только что добавленный элемент
+        // Если запись с таким именем уже существует, обновляем координаты
+        stops_[it->second].coordinates = coordinates;
+        stops_[it->second].position = geo::ToUnitVector(coordinates);
+        return it->second;
     }
+    // Если записи не существует, добавляем новый объект Stop и обновляем карту
+    const auto id = static_cast<StopId>(stops_.size());
+    stops_.push_back(Stop{StoreName(name), coordinates, id, geo::ToUnitVector(coordinates)});
+    stops_map_[stops_.back().name] = id; // Ключ ссылается на название в name_storage_
+    stop_to_buses_.emplace_back();
+    return id;
 }
 
-void TransportCatalogue::AddBus(const std::string& name, const std::vector<const Stop*>& stops, bool is_round_trip) {
-    buses_.emplace_back(Bus{name, stops, is_round_trip});
-    buses_map_[name] = &buses_.back(); // Используем name
+BusId TransportCatalogue::AddBus(const std::string& name, const std::vector<StopId>& stops, bool is_round_trip) {
+    CheckNotFrozen();
+    ++version_;
+    const auto id = static_cast<BusId>(buses_.size());
+    buses_.push_back(Bus{StoreName(name), stops, is_round_trip, id});
+    buses_map_[buses_.back().name] = id;
 
-    for (const auto* stop : stops) {
-        stop_to_buses_map_[stop].insert(&buses_.back()); // Используем указатели
+    // Маршрут добавляется последним, поэтому повтор остановки виден по концу списка
+    for (const StopId stop_id : stops) {
+        auto& stop_buses = stop_to_buses_.at(stop_id);
+        if (stop_buses.empty() || stop_buses.back() != id) {
+            stop_buses.push_back(id);
+        }
     }
+    return id;
 }
     
-void TransportCatalogue::SetDistance(const Stop* from, const Stop* to, int distance) {
-    if (from != nullptr && to != nullptr) {
-        between_stops_distance_[{from, to}] = distance; // Добавляем расстояние в мапу
-    }
-    //else std::cout << "\n Error SetDistance \n";// Сюда попадать не должны
+void TransportCatalogue::SetDistance(StopId from, StopId to, int distance) {
+    CheckNotFrozen();
+    between_stops_distance_.Set(from, to, distance); // Добавляем расстояние в таблицу
+    ++version_;
 }
 
-int TransportCatalogue::GetDistance(const Stop* from, const Stop* to) const {
+int TransportCatalogue::GetDistance(StopId from, StopId to) const {
     // Проверяем, существует ли расстояние от 'from' до 'to'
-    if (between_stops_distance_.count({from, to})) {
-        return between_stops_distance_.at({from, to});
+    if (const int* distance = between_stops_distance_.Find(from, to)) {
+        return *distance;
     }
     // Проверяем, существует ли расстояние от 'to' до 'from'
-    else if (between_stops_distance_.count({to, from})) {
-        return between_stops_distance_.at({to, from});
+    if (const int* distance = between_stops_distance_.Find(to, from)) {
+        return *distance;
     }
     // Если расстояние не найдено, возвращаем 0
     return 0;
 }
 
-const Bus* TransportCatalogue::FindBus(const std::string& name) const {
+std::vector<int> TransportCatalogue::GetSegmentDistances(const std::vector<StopId>& stops) const {
+    std::vector<int> distances;
+    distances.reserve(stops.empty() ? 0 : stops.size() - 1);
+    for (size_t k = 0; k + 1 < stops.size(); ++k) {
+        distances.push_back(GetDistance(stops[k], stops[k + 1]));
+    }
+    return distances;
+}
+
+std::vector<int> TransportCatalogue::GetReverseSegmentDistances(const std::vector<StopId>& stops) const {
+    std::vector<int> distances;
+    distances.reserve(stops.empty() ? 0 : stops.size() - 1);
+    for (size_t k = 0; k + 1 < stops.size(); ++k) {
+        distances.push_back(GetDistance(stops[k + 1], stops[k]));
+    }
+    return distances;
+}
+
+const Bus* TransportCatalogue::FindBus(std::string_view name) const {
+    if (has_perfect_hash_) {
+        const BusId id = bus_names_.Find(name);
+        return id != PerfectHash::NO_ID && buses_[id].name == name ? &buses_[id] : nullptr;
+    }
     auto it = buses_map_.find(name);
-    return it != buses_map_.end() ? it->second : nullptr;
+    return it != buses_map_.end() ? &buses_[it->second] : nullptr;
 }
 
-const Stop* TransportCatalogue::FindStop(const std::string& name) const {
+const Stop* TransportCatalogue::FindStop(std::string_view name) const {
+    if (has_perfect_hash_) {
+        const StopId id = stop_names_.Find(name);
+        return id != PerfectHash::NO_ID && stops_[id].name == name ? &stops_[id] : nullptr;
+    }
     auto it = stops_map_.find(name);
-    return it != stops_map_.end() ? it->second : nullptr;
+    return it != stops_map_.end() ? &stops_[it->second] : nullptr;
 }
 
-BusInfo TransportCatalogue::GetBusInfo(const std::string& name, int request_id) const {
+const Stop& TransportCatalogue::GetStopById(StopId id) const {
+    return stops_.at(id);
+}
+
+const Bus& TransportCatalogue::GetBusById(BusId id) const {
+    return buses_.at(id);
+}
+
+BusInfo TransportCatalogue::GetBusInfo(std::string_view name, int request_id) const {
+    if (!has_bus_infos_) {
+        throw std::logic_error("Bus infos are not prepared");
+    }
     const Bus* bus = FindBus(name); // Используем FindBus для поиска автобуса
-    if (bus) {
-        BusInfo bus_info;
-        bus_info.request_id = request_id; // Устанавливаем request_id
-        // Количество остановок
-        bus_info.stop_count = bus->is_round_trip ? static_cast<int>(bus->stops.size()) : static_cast<int>(bus->stops.size() * 2 - 1);
-
-        // Подсчет уникальных остановок без копирования
-        std::unordered_map<std::string, int> stop_counter;
-        for (const auto& stop : bus->stops) {
-            stop_counter[stop->name]++;
-        }
-        bus_info.unique_stop_count = static_cast<int>(stop_counter.size());
-
-        // Длина маршрута
-        double route_length = 0.0;
-        double geographical_distance = 0.0; 
-
-        // Вектор для хранения развернутого маршрута
-        std::vector<const Stop*> expanded_stops= bus->stops;        
-        if (!bus->is_round_trip) {
-            // Добавляем остановки в обратном порядке
-            for (size_t i = bus->stops.size()-1; i > 0; --i) {
-            expanded_stops.push_back(bus->stops[i - 1]);
-            }
-        }
-        
-        // Теперь у нас есть развернутый маршрут в expanded_stops
-        for (size_t i = 0; i < expanded_stops.size() - 1; i++) {
-            const auto& from_stop = expanded_stops[i];
-            const auto& to_stop = expanded_stops[i + 1];
-
-            // Получаем расстояние от текущей остановки до следующей
-            auto it = between_stops_distance_.find({from_stop, to_stop});
-            auto reverse_it = between_stops_distance_.find({to_stop, from_stop});
-
-            if (it != between_stops_distance_.end() && it->second > 0) {
-                route_length += it->second; // Добавляем расстояние
-            } else if (reverse_it != between_stops_distance_.end() && reverse_it->second > 0) {
-                route_length += reverse_it->second; // Добавляем расстояние в обратном направлении
-            }
-            
-            // Добавляем географическое расстояние
-            geographical_distance += ComputeDistance(from_stop->coordinates, to_stop->coordinates);
-        }
+    if (!bus) {
+        return BusInfo{}; // Если автобус не найден
+    }
+    BusInfo bus_info = bus_infos_[bus->id];
+    bus_info.request_id = request_id; // Устанавливаем request_id
+    return bus_info;
+}
+
+void TransportCatalogue::PrepareBusInfos() {
+    CheckFrozen();
+    bus_infos_.resize(buses_.size());
+    parallel::ParallelFor(buses_.size(), [this](size_t bus_id) {
+        bus_infos_[bus_id] = ComputeBusInfo(buses_[bus_id]);
+    });
+    has_bus_infos_ = true;
+}
+
+BusInfo TransportCatalogue::ComputeBusInfo(const Bus& bus) const {
+    BusInfo bus_info{};
+    const size_t stops_count = bus.stops.size();
+    if (stops_count == 0) {
+        return bus_info;
+    }
+    // Количество остановок
+    bus_info.stop_count = bus.is_round_trip ? static_cast<int>(stops_count) : static_cast<int>(stops_count * 2 - 1);
+
+    // Подсчет уникальных остановок по номерам без хеш-таблицы
+    std::vector<StopId> unique_stops = bus.stops;
+    std::sort(unique_stops.begin(), unique_stops.end());
+    bus_info.unique_stop_count = static_cast<int>(
+        std::unique(unique_stops.begin(), unique_stops.end()) - unique_stops.begin());
+
+    // Длина маршрута
+    double route_length = 0.0;
+    static thread_local geo::UnitVectorPath path;
+    path.Clear();
 
-        // Устанавливаем общую длину маршрута
-        bus_info.route_length = route_length;
+    // Развернутый маршрут не копируется: для некольцевого после последней
+    // остановки позиции идут в обратном порядке
+    const size_t expanded_count = static_cast<size_t>(bus_info.stop_count);
+    const auto stop_at = [&bus, stops_count](size_t i) {
+        return bus.stops[i < stops_count ? i : 2 * stops_count - 2 - i];
+    };
+    for (size_t i = 0; i + 1 < expanded_count; i++) {
+        const StopId from_stop = stop_at(i);
+        const StopId to_stop = stop_at(i + 1);
 
-        // Вычисляем коэффициент извилистости (C)
-        if (geographical_distance > 0.0) {
-            bus_info.curvature = route_length / geographical_distance; // C = L / D
-        } else {
-            bus_info.curvature = 1.0L; // Если географическое расстояние равно 0, устанавливаем извилистость в 1
+        // Получаем расстояние от текущей остановки до следующей
+        const int* distance = between_stops_distance_.Find(from_stop, to_stop);
+        if (distance && *distance > 0) {
+            route_length += *distance; // Добавляем расстояние
+        } else if (const int* reverse_distance = between_stops_distance_.Find(to_stop, from_stop);
+                   reverse_distance && *reverse_distance > 0) {
+            route_length += *reverse_distance; // Добавляем расстояние в обратном направлении
         }
-           
-        return bus_info; // Возвращаем уникальный указатель
+
+        path.Add(stops_[from_stop].position);
+    }
+    path.Add(stops_[stop_at(expanded_count - 1)].position);
+    // Географическое расстояние считается пакетно по всей последовательности
+    const double geographical_distance = path.ComputeLength();
+
+    // Устанавливаем общую длину маршрута
+    bus_info.route_length = route_length;
+
+    // Вычисляем коэффициент извилистости (C)
+    if (geographical_distance > 0.0) {
+        bus_info.curvature = route_length / geographical_distance; // C = L / D
+    } else {
+        bus_info.curvature = 1.0; // Если географическое расстояние равно 0, устанавливаем извилистость в 1
     }
-    return BusInfo{}; // Если автобус не найден
+    return bus_info;
 }
 
-const std::unordered_set<const Bus*, CustomHash>& TransportCatalogue::GetBusesByStop(const std::string& stop_name) const {
-    auto stop_it = stops_map_.find(stop_name); // Используем stop_name
-    if (stop_it != stops_map_.end()) {
-        const Stop* stop = stop_it->second;
-        auto bus_it = stop_to_buses_map_.find(stop);
-        if (bus_it != stop_to_buses_map_.end()) {
-            return bus_it->second;
-        }
+void TransportCatalogue::PrepareStopIndex() {
+    CheckFrozen();
+    stop_index_.Build(stops_);
+    has_stop_index_ = true;
+}
+
+const StopIndex& TransportCatalogue::GetStopIndex() const {
+    if (!has_stop_index_) {
+        throw std::logic_error("Stop index is not prepared");
     }
-    static const std::unordered_set<const Bus*, CustomHash> empty_set;
-    return empty_set;
+    return stop_index_;
+}
+
+std::vector<StopIndex::NearbyStop> TransportCatalogue::FindNearestStops(geo::Coordinates point, size_t count) const {
+    return GetStopIndex().FindNearest(point, count);
+}
+
+std::vector<StopId> TransportCatalogue::FindStopsInArea(geo::Coordinates min, geo::Coordinates max) const {
+    return GetStopIndex().FindInArea(min, max);
 }
 
-const std::deque<Stop>& TransportCatalogue::GetAllStops() const {
+const std::vector<BusId>& TransportCatalogue::GetBusesByStop(StopId stop_id) const {
+    return stop_to_buses_.at(stop_id);
+}
+
+const std::vector<Stop>& TransportCatalogue::GetAllStops() const {
     return stops_;
 }
 
-const std::deque<Bus>& TransportCatalogue::GetAllBuses() const {
+const std::vector<Bus>& TransportCatalogue::GetAllBuses() const {
     return buses_;
 }
 
 const std::map<std::string_view, const Bus*> TransportCatalogue::GetSortedAllBuses() const {
     std::map<std::string_view, const Bus*> result;
-    for (const auto& bus : buses_map_) {
-        result.emplace(bus.first, bus.second);
+    // Повторно добавленный маршрут заменяет прежний, как при поиске по названию
+    for (const Bus& bus : buses_) {
+        result[bus.name] = &bus;
     }
     return result;
 }
 
 const std::map<std::string_view, const Stop*> TransportCatalogue::GetSortedAllStops() const {
     std::map<std::string_view, const Stop*> result;
-    for (const auto& stop : stops_map_) {
-        result.emplace(stop.first, stop.second);
+    for (const Stop& stop : stops_) {
+        result.emplace(stop.name, &stop);
     }
     return result;
 }
@@ -166,4 +578,73 @@ const RoutingSettings& TransportCatalogue::GetRoutingSettings() const {
     return routing_settings_;
 }
 
+uint64_t TransportCatalogue::GetVersion() const {
+    return version_;
+}
+
+void TransportCatalogue::Freeze() {
+    if (is_frozen_) {
+        return;
+    }
+
+    // Названия остановок, затем маршрутов подряд в одном буфере; место
+    // зарезервировано заранее, поэтому буфер не перемещается при заполнении
+    size_t names_size = 0;
+    for (const Stop& stop : stops_) {
+        names_size += stop.name.size();
+    }
+    for (const Bus& bus : buses_) {
+        names_size += bus.name.size();
+    }
+    std::vector<char> arena;
+    arena.reserve(names_size);
+    const auto move_name = [&arena](std::string_view& name) {
+        const size_t offset = arena.size();
+        arena.insert(arena.end(), name.begin(), name.end());
+        name = std::string_view(arena.data() + offset, name.size());
+    };
+
+    std::vector<std::pair<std::string_view, uint32_t>> stop_keys;
+    stop_keys.reserve(stops_.size());
+    for (Stop& stop : stops_) {
+        move_name(stop.name);
+        stop_keys.emplace_back(stop.name, stop.id);
+    }
+    // Для повторяющегося названия маршрута ключом остаётся добавленный последним
+    std::vector<std::pair<std::string_view, uint32_t>> bus_keys;
+    for (Bus& bus : buses_) {
+        const bool is_key = buses_map_.at(bus.name) == bus.id;
+        move_name(bus.name);
+        if (is_key) {
+            bus_keys.emplace_back(bus.name, bus.id);
+        }
+    }
+    name_arena_ = std::move(arena);
+
+    // Ключи хеш-таблиц указывают в name_storage_, поэтому таблицы
+    // освобождаются вместе с ним
+    std::unordered_map<std::string_view, StopId, CustomHash>().swap(stops_map_);
+    std::unordered_map<std::string_view, BusId, CustomHash>().swap(buses_map_);
+    std::deque<std::string>().swap(name_storage_);
+    has_perfect_hash_ = stop_names_.Build(stop_keys) && bus_names_.Build(bus_keys);
+    if (!has_perfect_hash_) {
+        stop_names_ = {};
+        bus_names_ = {};
+        for (const auto& [name, id] : stop_keys) {
+            stops_map_[name] = id;
+        }
+        for (const auto& [name, id] : bus_keys) {
+            buses_map_[name] = id;
+        }
+    }
+
+    stops_.shrink_to_fit();
+    buses_.shrink_to_fit();
+    for (auto& stop_buses : stop_to_buses_) {
+        stop_buses.shrink_to_fit();
+    }
+    stop_to_buses_.shrink_to_fit();
+    is_frozen_ = true;
+}
+
 } // namespace transport_catalogue
\ No newline at end of file
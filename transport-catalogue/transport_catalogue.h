@@ -1,5 +1,6 @@
 #pragma once
 
+#include <cstdint>
 #include <memory>
 #include <string>
 #include <string_view>
@@ -14,17 +15,26 @@
 
 namespace transport_catalogue {
 
+// Порядковые номера остановок и автобусов в каталоге, выдаются при добавлении
+using StopId = uint32_t;
+using BusId = uint32_t;
+
+// Названия хранит каталог: до Freeze() — по отдельности, после — в одном
+// непрерывном буфере
 struct Stop {
-    std::string name;
+    std::string_view name;
     geo::Coordinates coordinates;
+    StopId id = 0;
+    geo::UnitVector position; // Координаты на единичной сфере для расстояний
 };
 
 struct Bus {
-    std::string name;
-    std::vector<const Stop*> stops; // Используем вектор для хранения указателей на остановки
+    std::string_view name;
+    std::vector<StopId> stops; // Номера остановок: 4 байта вместо указателя
     bool is_round_trip;
+    BusId id = 0;
 
-    const std::string& GetName() const {
+    std::string_view GetName() const {
         return name; // Добавим метод для доступа к имени автобуса
     }
 
@@ -42,16 +52,6 @@ struct BusInfo {
 };
 
 struct CustomHash {
-    // Хеш-функция для Bus
-    std::size_t operator()(const Bus* bus) const {
-        return std::hash<std::string>()(bus->GetName());
-    }
-
-    // Хеш-функция для Stop
-    std::size_t operator()(const Stop* stop) const {
-        return std::hash<const Stop*>()(stop);
-    }
-
     // Хеш-функция для std::string
     std::size_t operator()(const std::string& str) const {
         return std::hash<std::string>()(str);
@@ -61,13 +61,118 @@ struct CustomHash {
     std::size_t operator()(std::string_view str) const {
         return std::hash<std::string_view>()(str);
     }
+};
+
+// Расстояния между парами остановок в плоской хеш-таблице с открытой
+// адресацией: ключ — оба номера в одном 64-битном слове, перемешанный
+// финализатором splitmix64, коллизии разрешаются линейным пробированием.
+// Поиск — одно-два чтения подряд идущих ячеек вместо узлов unordered_map.
+class DistanceTable {
+public:
+    void Set(StopId from, StopId to, int distance);
+    // nullptr, если расстояние from -> to не задано
+    const int* Find(StopId from, StopId to) const;
 
-    // Хеш-функция для пар остановок
-    std::size_t operator()(const std::pair<const Stop*, const Stop*>& stops) const {
-        auto hash1 = std::hash<const Stop*>()(stops.first);
-        auto hash2 = std::hash<const Stop*>()(stops.second);
-        return hash1 ^ (hash2 << 1); // Комбинируем хеши
+private:
+    static constexpr uint64_t EMPTY_KEY = ~uint64_t{0};
+
+    struct Slot {
+        uint64_t key = EMPTY_KEY;
+        int distance = 0;
+    };
+
+    static uint64_t MakeKey(StopId from, StopId to) {
+        return static_cast<uint64_t>(from) << 32 | to;
     }
+    size_t FindSlot(uint64_t key) const;
+    void Rehash(size_t capacity);
+
+    std::vector<Slot> slots_;  // размер — степень двойки, заполнено не больше половины
+    size_t size_ = 0;
+};
+
+// Минимальная совершенная хеш-функция названий по схеме «хеш и смещение»
+// (CHD): ключи раскладываются по корзинам, в среднем по четыре, и для
+// каждой корзины, начиная с самых больших, подбирается seed, при котором
+// все её ключи попадают в ещё свободные ячейки. n ключей занимают ровно n
+// ячеек; поиск — хеш названия, seed его корзины и одна ячейка. Неизвестное
+// название тоже попадает в какую-то ячейку, поэтому вызывающий сверяет
+// название по найденному номеру.
+class PerfectHash {
+public:
+    static constexpr uint32_t NO_ID = static_cast<uint32_t>(-1);
+
+    // Названия должны быть различными; false, если seed подобрать не удалось
+    bool Build(const std::vector<std::pair<std::string_view, uint32_t>>& keys);
+    // Номер-кандидат для названия или NO_ID, если ключей нет
+    uint32_t Find(std::string_view name) const;
+
+private:
+    static constexpr uint32_t KEYS_PER_BUCKET = 4;
+    static constexpr uint32_t MAX_SEED = 1u << 24;
+
+    static uint64_t HashName(std::string_view name);
+    size_t GetSlot(uint64_t hash, uint32_t seed) const;
+
+    std::vector<uint32_t> seeds_;  // по корзинам
+    std::vector<uint32_t> ids_;    // по ячейкам
+};
+
+// Статическое k-d дерево по положениям остановок на единичной сфере.
+// Порядок хордовых расстояний совпадает с порядком расстояний по дуге,
+// поэтому ближайшие остановки ищутся обычным обходом дерева с отсечением
+// по разделяющей плоскости. Дерево неявное: корень поддиапазона лежит в
+// его середине, отдельных узлов и указателей нет.
+class StopIndex {
+public:
+    struct NearbyStop {
+        StopId id;
+        double distance;  // по поверхности Земли, в метрах
+    };
+
+    void Build(const std::vector<Stop>& stops);
+    // До count ближайших остановок по возрастанию расстояния; при равных
+    // расстояниях раньше идёт меньший номер
+    std::vector<NearbyStop> FindNearest(geo::Coordinates point, size_t count) const;
+    // Остановки внутри прямоугольника широт и долгот (границы включаются)
+    // по возрастанию номера. Прямоугольник не пересекает 180-й меридиан
+    std::vector<StopId> FindInArea(geo::Coordinates min, geo::Coordinates max) const;
+    // Остановки не дальше radius метров от точки по возрастанию номера
+    std::vector<NearbyStop> FindWithinRadius(geo::Coordinates point, double radius) const;
+
+private:
+    struct Node {
+        geo::UnitVector position;
+        geo::Coordinates coordinates;
+        StopId id = 0;
+        uint8_t axis = 0;  // ось разделяющей плоскости: 0 — x, 1 — y, 2 — z
+    };
+
+    // Кандидат в ближайшие: сравнивается по квадрату хорды, затем по номеру
+    struct Candidate {
+        double squared_chord;
+        const Node* node;
+
+        bool operator<(const Candidate& other) const {
+            return squared_chord < other.squared_chord ||
+                   (squared_chord == other.squared_chord && node->id < other.node->id);
+        }
+    };
+
+    struct Box {
+        double min[3];
+        double max[3];
+    };
+
+    void BuildRange(size_t begin, size_t end);
+    void SearchNearest(size_t begin, size_t end, const geo::UnitVector& point, size_t count,
+                       std::vector<Candidate>& heap) const;
+    void SearchArea(size_t begin, size_t end, const Box& box, geo::Coordinates min, geo::Coordinates max,
+                    std::vector<StopId>& result) const;
+    void SearchRadius(size_t begin, size_t end, const geo::UnitVector& point, double max_squared_chord,
+                      double radius, std::vector<NearbyStop>& result) const;
+
+    std::vector<Node> nodes_;
 };
 
 struct RoutingSettings {
@@ -75,31 +180,85 @@ struct RoutingSettings {
     double bus_velocity = 0.0;
 };
 
+// Остановки и автобусы получают плотные номера при добавлении; внутри
+// каталога и в роутере всё адресуется номерами, а названия ищутся только
+// на границе запросов (FindStop, FindBus)
 class TransportCatalogue {
 public:
-    void AddStop(const std::string& name, const geo::Coordinates& coordinates);
-    void AddBus(const std::string& name, const std::vector<const Stop*>& stops, bool is_round_trip);
-    void SetDistance(const Stop* from, const Stop* to, int distance);
-    int GetDistance(const Stop* from, const Stop* to) const;
-    const Bus* FindBus(const std::string& name) const;
-    const Stop* FindStop(const std::string& name) const;
-    BusInfo GetBusInfo(const std::string& name, int request_id) const;
-    const std::unordered_set<const Bus*, CustomHash>& GetBusesByStop(const std::string& stop_name) const;
-    const std::deque<Stop>& GetAllStops() const;
-    const std::deque<Bus>& GetAllBuses() const;
+    // Изменение каталога после Freeze() бросает std::logic_error.
+    // Для существующей остановки обновляет координаты и возвращает её номер
+    StopId AddStop(const std::string& name, const geo::Coordinates& coordinates);
+    BusId AddBus(const std::string& name, const std::vector<StopId>& stops, bool is_round_trip);
+    void SetDistance(StopId from, StopId to, int distance);
+    // Расстояние from -> to, а если оно не задано — to -> from, иначе 0
+    int GetDistance(StopId from, StopId to) const;
+    // Расстояния по ходу маршрута: элемент k — от stops[k] до stops[k + 1]
+    std::vector<int> GetSegmentDistances(const std::vector<StopId>& stops) const;
+    // То же против хода: элемент k — от stops[k + 1] до stops[k]
+    std::vector<int> GetReverseSegmentDistances(const std::vector<StopId>& stops) const;
+    const Bus* FindBus(std::string_view name) const;
+    const Stop* FindStop(std::string_view name) const;
+    const Stop& GetStopById(StopId id) const;
+    const Bus& GetBusById(BusId id) const;
+    // Статистика из PrepareBusInfos(); без неё бросает std::logic_error
+    BusInfo GetBusInfo(std::string_view name, int request_id) const;
+    // Считает статистику всех маршрутов параллельно; вызывается после
+    // Freeze(), поэтому статистика не устаревает
+    void PrepareBusInfos();
+    // Строит пространственный индекс остановок; вызывается после Freeze(),
+    // поэтому индекс не устаревает
+    void PrepareStopIndex();
+    // Индекс из PrepareStopIndex(); без него бросает std::logic_error
+    const StopIndex& GetStopIndex() const;
+    // Ближайшие к точке остановки и остановки в прямоугольнике, см. StopIndex
+    std::vector<StopIndex::NearbyStop> FindNearestStops(geo::Coordinates point, size_t count) const;
+    std::vector<StopId> FindStopsInArea(geo::Coordinates min, geo::Coordinates max) const;
+    // Маршруты через остановку, каждый один раз, в порядке добавления
+    const std::vector<BusId>& GetBusesByStop(StopId stop_id) const;
+    const std::vector<Stop>& GetAllStops() const;
+    const std::vector<Bus>& GetAllBuses() const;
     void SetRoutingSettings(const RoutingSettings& settings);
     const RoutingSettings& GetRoutingSettings() const;
     const std::map<std::string_view, const Bus*> GetSortedAllBuses() const;
     const std::map<std::string_view, const Stop*> GetSortedAllStops() const;
-    
+    // Номер версии данных: растёт при каждом изменении остановок, маршрутов
+    // или расстояний. Настройки маршрутизации в версию не входят: от них
+    // зависят только веса рёбер, а не структура графа
+    uint64_t GetVersion() const;
+    // Переводит каталог в режим только для чтения после загрузки: названия
+    // собираются в один буфер, хеш-таблицы названий заменяются минимальной
+    // совершенной хеш-функцией, запасная ёмкость векторов освобождается
+    void Freeze();
+
 private:
-    std::deque<Stop> stops_; // Дек объектов Stop
-    std::deque<Bus> buses_;   // Дек объектов Bus
-    std::unordered_map<std::string, const Stop*> stops_map_;
-    std::unordered_map<std::string, const Bus*> buses_map_;
-    std::unordered_map<const Stop*, std::unordered_set<const Bus*, CustomHash>, CustomHash> stop_to_buses_map_;
-    std::unordered_map<std::pair<const Stop*, const Stop*>, int, CustomHash> between_stops_distance_;
+    BusInfo ComputeBusInfo(const Bus& bus) const;
+    void CheckNotFrozen() const;
+    void CheckFrozen() const;
+    // Копия названия в хранилище каталога; строки дека не перемещаются
+    std::string_view StoreName(const std::string& name);
+
+    std::vector<Stop> stops_;
+    std::vector<Bus> buses_;
+    // До Freeze(): названия и хеш-таблицы по ним (и после, если совершенную
+    // хеш-функцию построить не удалось — тогда ключи указывают в name_arena_)
+    std::deque<std::string> name_storage_;
+    std::unordered_map<std::string_view, StopId, CustomHash> stops_map_;
+    std::unordered_map<std::string_view, BusId, CustomHash> buses_map_;
+    // После Freeze(): все названия подряд и поиск по ним
+    std::vector<char> name_arena_;
+    PerfectHash stop_names_;
+    PerfectHash bus_names_;
+    bool has_perfect_hash_ = false;  // иначе поиск по хеш-таблицам
+    bool is_frozen_ = false;
+    std::vector<std::vector<BusId>> stop_to_buses_;  // по номеру остановки
+    DistanceTable between_stops_distance_;
+    // Статистика по номеру маршрута
+    std::vector<BusInfo> bus_infos_;
+    bool has_bus_infos_ = false;
+    StopIndex stop_index_;
+    bool has_stop_index_ = false;
     RoutingSettings routing_settings_;
+    uint64_t version_ = 0;
 };
 
 } // namespace transport_catalogue
\ No newline at end of file
@@ -1,109 +1,842 @@
 #include "transport_router.h"
+#include "alt_router.h"
+#include "bidirectional_router.h"
+#include "blocked_router.h"
+#include "compact_router.h"
+#include "component_router.h"
+#include "contraction_hierarchy.h"
+#include "dijkstra_router.h"
+#include "parallel.h"
+#include "raptor_router.h"
+#include "router_storage.h"
+#include "router.h"
 #include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <iostream>
+#include <numeric>
 
 namespace transport {
 
+namespace {
+
+// Из параллельных рёбер поездки (from, to) на кратчайшем пути может
+// оказаться только самое короткое. Вес у всех рёбер поездки — расстояние,
+// время профиля пропорционально ему, поэтому доминирование по расстоянию
+// верно для любого профиля. При равных расстояниях остаётся ребро,
+// добавленное первым: его же выбирали движки при строгом сравнении весов,
+// так что ответы не меняются. Порядок оставшихся рёбер сохраняется.
+std::vector<graph::Edge<double>> PruneDominatedEdges(const std::vector<graph::Edge<double>>& edges,
+                                                     size_t vertex_count) {
+    // Рёбра раскладываются по начальной вершине подсчётом с сохранением порядка
+    std::vector<size_t> offsets(vertex_count + 1, 0);
+    for (const auto& edge : edges) {
+        ++offsets[edge.from + 1];
+    }
+    for (size_t vertex = 0; vertex < vertex_count; ++vertex) {
+        offsets[vertex + 1] += offsets[vertex];
+    }
+    std::vector<size_t> order(edges.size());
+    std::vector<size_t> next_slots(offsets.begin(), offsets.end() - 1);
+    for (size_t index = 0; index < edges.size(); ++index) {
+        order[next_slots[edges[index].from]++] = index;
+    }
+
+    // Лучшее ребро в каждую вершину для текущей начальной вершины
+    constexpr graph::VertexId NO_VERTEX = static_cast<graph::VertexId>(-1);
+    std::vector<graph::VertexId> owners(vertex_count, NO_VERTEX);
+    std::vector<size_t> best_edges(vertex_count);
+    std::vector<bool> is_kept(edges.size(), false);
+    for (graph::VertexId from = 0; from < vertex_count; ++from) {
+        for (size_t slot = offsets[from]; slot < offsets[from + 1]; ++slot) {
+            const size_t index = order[slot];
+            const graph::VertexId to = edges[index].to;
+            if (owners[to] != from) {
+                owners[to] = from;
+                best_edges[to] = index;
+            } else if (edges[index].weight < edges[best_edges[to]].weight) {
+                best_edges[to] = index;
+            }
+        }
+        for (size_t slot = offsets[from]; slot < offsets[from + 1]; ++slot) {
+            const size_t index = order[slot];
+            is_kept[index] = best_edges[edges[index].to] == index;
+        }
+    }
+
+    std::vector<graph::Edge<double>> result;
+    result.reserve(std::count(is_kept.begin(), is_kept.end(), true));
+    for (size_t index = 0; index < edges.size(); ++index) {
+        if (is_kept[index]) {
+            result.push_back(edges[index]);
+        }
+    }
+    return result;
+}
+
+// Остановки, через которые проходит хотя бы один маршрут или пеший переход,
+// в порядке обратного Катхилла–Макки по графу соседства на маршрутах и
+// переходах: поиск в ширину от вершины наименьшей степени, соседи — по
+// возрастанию степени, итог разворачивается. Соседние остановки получают
+// близкие номера, поэтому обход графа и строки таблиц движков ближе друг к
+// другу в памяти. walk_neighbours пуст, если переходов нет.
+// Нумерация вершин решает, какой из маршрутов равного времени вернут движки:
+// по сравнению с прежним порядком остановок по названиям ответ с тем же
+// total_time может содержать другой автобус, число пролётов или остановку
+// пересадки. Порядок по названиям на сети из 1500 остановок замедлял
+// построение all_pairs с 34 до 61 с, поэтому он не сохранён.
+std::vector<transport_catalogue::StopId> OrderServedStops(
+        size_t stop_count, const std::vector<const transport_catalogue::Bus*>& buses,
+        const std::vector<std::vector<transport_catalogue::StopIndex::NearbyStop>>& walk_neighbours) {
+    using transport_catalogue::StopId;
+    std::vector<std::vector<StopId>> neighbours(stop_count);
+    std::vector<bool> is_served(stop_count, false);
+    for (StopId stop_id = 0; stop_id < walk_neighbours.size(); ++stop_id) {
+        for (const auto& walk_neighbour : walk_neighbours[stop_id]) {
+            is_served[stop_id] = true;
+            neighbours[stop_id].push_back(walk_neighbour.id);
+        }
+    }
+    for (const auto* bus : buses) {
+        for (size_t k = 0; k < bus->stops.size(); ++k) {
+            const StopId stop_id = bus->stops[k];
+            is_served[stop_id] = true;
+            if (k > 0 && bus->stops[k - 1] != stop_id) {
+                neighbours[stop_id].push_back(bus->stops[k - 1]);
+                neighbours[bus->stops[k - 1]].push_back(stop_id);
+            }
+        }
+    }
+    const auto by_degree = [&neighbours](StopId lhs, StopId rhs) {
+        return std::pair{neighbours[lhs].size(), lhs} < std::pair{neighbours[rhs].size(), rhs};
+    };
+    for (auto& stop_neighbours : neighbours) {
+        std::sort(stop_neighbours.begin(), stop_neighbours.end());
+        stop_neighbours.erase(std::unique(stop_neighbours.begin(), stop_neighbours.end()), stop_neighbours.end());
+    }
+    std::vector<StopId> starts;
+    for (StopId stop_id = 0; stop_id < stop_count; ++stop_id) {
+        if (is_served[stop_id]) {
+            starts.push_back(stop_id);
+        }
+    }
+    std::sort(starts.begin(), starts.end(), by_degree);
+    for (auto& stop_neighbours : neighbours) {
+        std::sort(stop_neighbours.begin(), stop_neighbours.end(), by_degree);
+    }
+
+    std::vector<StopId> order;
+    order.reserve(starts.size());
+    std::vector<bool> is_visited(stop_count, false);
+    for (const StopId start : starts) {
+        if (is_visited[start]) {
+            continue;
+        }
+        is_visited[start] = true;
+        order.push_back(start);
+        for (size_t head = order.size() - 1; head < order.size(); ++head) {
+            for (const StopId neighbour : neighbours[order[head]]) {
+                if (!is_visited[neighbour]) {
+                    is_visited[neighbour] = true;
+                    order.push_back(neighbour);
+                }
+            }
+        }
+    }
+    std::reverse(order.begin(), order.end());
+    return order;
+}
+
+// Движок Engine отдельно на каждой компоненте связности графа
+template <typename Engine>
+std::unique_ptr<graph::RouteEngine<double>> MakeComponentEngine(const graph::DirectedWeightedGraph<double>& graph) {
+    return std::make_unique<graph::ComponentRouter<double>>(graph, [](const graph::DirectedWeightedGraph<double>& component) {
+        return std::make_unique<Engine>(component);
+    });
+}
+
+// Таблица последних рёбер кратчайших путей из файла состояния: на диагонали
+// рёбер нет, каждое ребро ведёт в вершину своего столбца, а цепочка рёбер
+// из любого столбца строки from без циклов приходит в from. prev_edge(from, to)
+// читает ячейку таблицы.
+template <typename TableEdgeId, typename PrevEdge>
+bool IsValidPrevEdgeTable(const std::vector<graph::Edge<double>>& edges, size_t vertex_count,
+                          TableEdgeId no_edge, PrevEdge prev_edge) {
+    enum class State : uint8_t { UNKNOWN, ON_PATH, REACHED, UNREACHED };
+    std::vector<State> states(vertex_count);
+    std::vector<graph::VertexId> path;
+    for (graph::VertexId from = 0; from < vertex_count; ++from) {
+        if (prev_edge(from, from) != no_edge) {
+            return false;
+        }
+        std::fill(states.begin(), states.end(), State::UNKNOWN);
+        states[from] = State::REACHED;
+        for (graph::VertexId to = 0; to < vertex_count; ++to) {
+            path.clear();
+            graph::VertexId vertex = to;
+            while (states[vertex] == State::UNKNOWN) {
+                const TableEdgeId edge_id = prev_edge(from, vertex);
+                if (edge_id == no_edge) {
+                    states[vertex] = State::UNREACHED;
+                    break;
+                }
+                if (edge_id >= edges.size() || edges[edge_id].to != vertex) {
+                    return false;
+                }
+                states[vertex] = State::ON_PATH;
+                path.push_back(vertex);
+                vertex = edges[edge_id].from;
+            }
+            // Цепочка зациклилась или пришла в вершину, до которой пути нет
+            if (!path.empty() && states[vertex] != State::REACHED) {
+                return false;
+            }
+            for (const graph::VertexId path_vertex : path) {
+                states[path_vertex] = State::REACHED;
+            }
+        }
+    }
+    return true;
+}
+
+}  // namespace
+
+std::optional<RouterEngine> ParseRouterEngine(std::string_view name) {
+    if (name == "all_pairs") {
+        return RouterEngine::ALL_PAIRS;
+    }
+    if (name == "dijkstra") {
+        return RouterEngine::DIJKSTRA;
+    }
+    if (name == "contraction_hierarchies") {
+        return RouterEngine::CONTRACTION_HIERARCHIES;
+    }
+    if (name == "blocked_all_pairs") {
+        return RouterEngine::BLOCKED_ALL_PAIRS;
+    }
+    if (name == "compact_all_pairs") {
+        return RouterEngine::COMPACT_ALL_PAIRS;
+    }
+    if (name == "raptor") {
+        return RouterEngine::RAPTOR;
+    }
+    if (name == "alt") {
+        return RouterEngine::ALT;
+    }
+    if (name == "bidirectional_dijkstra") {
+        return RouterEngine::BIDIRECTIONAL_DIJKSTRA;
+    }
+    return std::nullopt;
+}
+
+std::optional<GraphModel> ParseGraphModel(std::string_view name) {
+    if (name == "stop_pairs") {
+        return GraphModel::STOP_PAIRS;
+    }
+    if (name == "route_patterns") {
+        return GraphModel::ROUTE_PATTERNS;
+    }
+    return std::nullopt;
+}
+
+Router::Router() = default;
+
+Router::Router(const RouterSettings& settings, const transport_catalogue::TransportCatalogue& catalogue)
+    : settings_(settings)
+    , catalogue_version_(catalogue.GetVersion()) {
+    if (settings_.engine == RouterEngine::RAPTOR) {
+        BuildRaptor(catalogue);
+    } else {
+        BuildGraph(catalogue);
+    }
+}
+
+Router::~Router() = default;
+
+Router::Profile::Profile(size_t route_cache_size)
+    : route_cache(route_cache_size) {
+}
+
+Router::Profile::~Profile() = default;
+
+void Router::SetProfile(const std::string& name, const RoutingProfile& profile) {
+    if (!raptor_topology_ && !topology_.IsFrozen()) {
+        return;
+    }
+    profiles_[name] = MakeProfile(profile, false);
+}
+
+std::optional<RoutingProfile> Router::GetProfile(std::string_view name) const {
+    if (const Profile* profile = FindProfile(name)) {
+        return profile->parameters;
+    }
+    return std::nullopt;
+}
+
+const Router::Profile* Router::FindProfile(std::string_view name) const {
+    const auto it = profiles_.find(name);
+    return it == profiles_.end() ? nullptr : it->second.get();
+}
+
+std::unique_ptr<Router::Profile> Router::MakeProfile(const RoutingProfile& parameters, bool save_state) const {
+    auto profile = std::make_unique<Profile>(settings_.route_cache_size);
+    profile->parameters = parameters;
+    if (raptor_topology_) {
+        profile->raptor = std::make_unique<RaptorRouter>(*raptor_topology_);
+        profile->raptor->SetProfile(parameters);
+    } else {
+        profile->graph = MakeProfileGraph(parameters);
+        MakeEngine(*profile, save_state);
+    }
+    return profile;
+}
+
+graph::DirectedWeightedGraph<double> Router::MakeProfileGraph(const RoutingProfile& parameters) const {
+    const double wait_time = static_cast<double>(parameters.bus_wait_time);
+    // Предварительно рассчитываем коэффициент скорости
+    const double velocity_coef = parameters.bus_velocity * 1000.0 / 60.0;
+    const double walk_velocity_coef = settings_.walk_velocity * 1000.0 / 60.0;
+    return topology_.Reweighted([this, wait_time, velocity_coef, walk_velocity_coef](const graph::Edge<double>& edge) {
+        if (edge.span_count == WALK_SPAN_COUNT) {
+            return edge.weight / walk_velocity_coef;
+        }
+        if (edge.span_count != 0) {
+            return edge.weight / velocity_coef;
+        }
+        // Ожидание начинается в вершине остановки, высадка — в вершине «в автобусе»
+        return IsStopVertex(edge.from) ? wait_time : 0.0;
+    });
+}
+
+void Router::MakeEngine(Profile& profile, bool save_state) const {
+    const auto& stops_graph = profile.graph;
+    // Движки делят граф на компоненты связности, кроме сохраняемых в файл:
+    // их таблица — одна секция на весь граф
+    switch (settings_.engine) {
+        case RouterEngine::ALL_PAIRS:
+            profile.router = MakeComponentEngine<graph::Router<double>>(stops_graph);
+            break;
+        case RouterEngine::DIJKSTRA:
+            profile.router = MakeComponentEngine<graph::DijkstraRouter<double>>(stops_graph);
+            break;
+        case RouterEngine::CONTRACTION_HIERARCHIES:
+            profile.router = MakeComponentEngine<graph::ContractionHierarchyRouter<double>>(stops_graph);
+            break;
+        case RouterEngine::BLOCKED_ALL_PAIRS: {
+            auto router = std::make_unique<graph::BlockedRouter<double>>(stops_graph);
+            const size_t dimension = graph::BlockedRouter<double>::GetDimension(stops_graph.GetVertexCount());
+            if (save_state) {
+                SaveState({
+                    {router->GetWeights(), dimension * dimension * sizeof(double)},
+                    {router->GetPrevEdges(), dimension * dimension * sizeof(graph::EdgeId)}
+                });
+            }
+            profile.router = std::move(router);
+            break;
+        }
+        case RouterEngine::COMPACT_ALL_PAIRS: {
+            auto router = std::make_unique<graph::CompactRouter<double>>(stops_graph);
+            const size_t vertex_count = stops_graph.GetVertexCount();
+            if (save_state) {
+                SaveState({
+                    {router->GetTable(), vertex_count * vertex_count * sizeof(graph::CompactRouter<double>::CompactEdgeId)}
+                });
+            }
+            profile.router = std::move(router);
+            break;
+        }
+        case RouterEngine::ALT:
+            profile.router = MakeComponentEngine<graph::AltRouter<double>>(stops_graph);
+            break;
+        case RouterEngine::BIDIRECTIONAL_DIJKSTRA:
+            profile.router = MakeComponentEngine<graph::BidirectionalDijkstraRouter<double>>(stops_graph);
+            break;
+        case RouterEngine::RAPTOR:
+            break;
+    }
+}
+
+void Router::BuildRaptor(const transport_catalogue::TransportCatalogue& catalogue) {
+    stop_vertices_.resize(catalogue.GetAllStops().size());
+    std::iota(stop_vertices_.begin(), stop_vertices_.end(), graph::VertexId{0});
+    raptor_topology_ = std::make_unique<RaptorRouter>(catalogue, settings_);
+    profiles_[""] = MakeProfile({settings_.bus_wait_time, settings_.bus_velocity}, false);
+}
+
 void Router::BuildGraph(const transport_catalogue::TransportCatalogue& catalogue) {
-    const auto& all_stops = catalogue.GetSortedAllStops();
-    graph::DirectedWeightedGraph<double> stops_graph(all_stops.size() * 2);
-    std::unordered_map<std::string, graph::VertexId> stop_ids;
+    const bool is_pattern_model = settings_.graph_model == GraphModel::ROUTE_PATTERNS;
+    // В модели пар у остановки две вершины: до и после ожидания. В модели
+    // маршрутов ожидание несут рёбра посадки, и вершина одна.
+    const size_t stop_vertex_step = is_pattern_model ? 1 : 2;
+
+    std::vector<const transport_catalogue::Bus*> buses;
+    for (const auto& [bus_name, bus_info] : catalogue.GetSortedAllBuses()) {
+        buses.push_back(bus_info);
+    }
+    // Остановки без маршрутов и переходов в граф не попадают: маршрутов через
+    // них нет, а в таблицах всех пар каждая вершина стоит O(V) памяти
+    const auto walk_neighbours = FindWalkNeighbours(catalogue);
+    const auto stop_order = OrderServedStops(catalogue.GetAllStops().size(), buses, walk_neighbours);
+    stop_vertex_count_ = stop_order.size() * stop_vertex_step;
+    // Вершины «в автобусе» нумеруются после остановок в порядке маршрутов
+    std::vector<graph::VertexId> first_pattern_vertices(buses.size());
+    size_t vertex_count = stop_vertex_count_;
+    if (is_pattern_model) {
+        for (size_t index = 0; index < buses.size(); ++index) {
+            first_pattern_vertices[index] = vertex_count;
+            vertex_count += GetPatternVertexCount(*buses[index]);
+        }
+    }
+
+    graph::DirectedWeightedGraph<double> stops_graph(vertex_count);
+    stop_vertices_.assign(catalogue.GetAllStops().size(), NO_VERTEX);
     graph::VertexId vertex_id = 0;
 
-    // Создаем вершины и ребра ожидания
-    for (const auto& [stop_name, stop_info] : all_stops) {
-        stop_ids[stop_info->name] = vertex_id;
-        stops_graph.AddEdge({
-            stop_info->name,
-            0,
-            vertex_id,
-            vertex_id + 1,
-            static_cast<double>(settings_.bus_wait_time)
-        });
-        vertex_id += 2;
+    // Создаем вершины и ребра ожидания; время ожидания задаёт профиль
+    for (const transport_catalogue::StopId stop_id : stop_order) {
+        stop_vertices_[stop_id] = vertex_id;
+        if (!is_pattern_model) {
+            stops_graph.AddEdge({
+                stop_id,
+                0,
+                vertex_id,
+                vertex_id + 1,
+                0.0
+            });
+        }
+        vertex_id += stop_vertex_step;
     }
-    stop_ids_ = std::move(stop_ids);
 
-    // Предварительно рассчитываем коэффициент скорости
-    const double velocity_coef = settings_.bus_velocity * 1000.0 / 60.0;
-
-    // Создаем ребра поездки на автобусе
-    const auto& all_buses = catalogue.GetSortedAllBuses();
-    for (const auto& [bus_name, bus_info] : all_buses) {
-        const auto& stops = bus_info->stops;
-        const size_t stops_count = stops.size();
-        
-        for (size_t i = 0; i < stops_count; ++i) {
-            for (size_t j = i + 1; j < stops_count; ++j) {
-                const auto* stop_from = stops[i];
-                const auto* stop_to = stops[j];
-                
-                // Рассчитываем расстояние для прямого направления
-                int distance = 0;
-                for (size_t k = i + 1; k <= j; ++k) {
-                    distance += catalogue.GetDistance(stops[k - 1], stops[k]);
-                }                
-                // Добавляем прямое ребро
-                AddBusEdge(stops_graph, bus_info->name, static_cast<size_t>(j - i), 
-                                stop_from->name, stop_to->name, distance, velocity_coef);
-
-                // Для некольцевых маршрутов добавляем обратное ребро
-                if (!bus_info->is_round_trip) {
-                    int reverse_distance = 0;
-                    for (size_t k = j; k > i; --k) {
-                        reverse_distance += catalogue.GetDistance(stops[k], stops[k - 1]);
-                    }
-                    
-                    AddBusEdge(stops_graph, bus_info->name, static_cast<size_t>(j - i),
-                              stop_to->name, stop_from->name, reverse_distance, velocity_coef);
+    if (LoadState(vertex_count, catalogue)) {
+        return;
+    }
+
+    // Создаем ребра поездки на автобусе. Рёбра каждого маршрута строятся
+    // независимо в своём буфере, буферы сливаются в порядке названий
+    // маршрутов, поэтому номера рёбер не зависят от числа потоков.
+    std::vector<std::vector<graph::Edge<double>>> bus_edges(buses.size());
+    parallel::ParallelFor(buses.size(), [&](size_t index) {
+        bus_edges[index] = is_pattern_model
+            ? MakePatternEdges(*buses[index], catalogue, first_pattern_vertices[index])
+            : MakeBusEdges(*buses[index], catalogue);
+    });
+    std::vector<graph::Edge<double>> ride_edges;
+    for (auto& edges : bus_edges) {
+        ride_edges.insert(ride_edges.end(), edges.begin(), edges.end());
+        edges = {};
+    }
+    // В цепочках маршрутов параллельных рёбер нет
+    if (!is_pattern_model) {
+        ride_edges = PruneDominatedEdges(ride_edges, vertex_count);
+    }
+    for (const auto& edge : ride_edges) {
+        stops_graph.AddEdge(edge);
+    }
+
+    // Пешие переходы идут после поездок, так что без них номера рёбер не
+    // меняются. Переход ведёт в вершину остановки до ожидания: дальше по
+    // ребру ожидания или посадки, как после приезда на автобусе.
+    for (transport_catalogue::StopId stop_id = 0; stop_id < walk_neighbours.size(); ++stop_id) {
+        for (const auto& walk_neighbour : walk_neighbours[stop_id]) {
+            stops_graph.AddEdge({
+                walk_neighbour.id,
+                WALK_SPAN_COUNT,
+                stop_vertices_[stop_id],
+                stop_vertices_[walk_neighbour.id],
+                walk_neighbour.distance
+            });
+        }
+    }
+
+    stops_graph.Freeze();
+    topology_ = std::move(stops_graph);
+    profiles_[""] = MakeProfile({settings_.bus_wait_time, settings_.bus_velocity}, true);
+}
+
+bool Router::IsStatePersistent() const {
+    return !settings_.state_file.empty()
+        && (settings_.engine == RouterEngine::BLOCKED_ALL_PAIRS || settings_.engine == RouterEngine::COMPACT_ALL_PAIRS);
+}
+
+bool Router::LoadState(size_t vertex_count, const transport_catalogue::TransportCatalogue& catalogue) {
+    if (!IsStatePersistent()) {
+        return false;
+    }
+    auto file = MappedFile::Open(settings_.state_file);
+    if (!file) {
+        return false;
+    }
+    auto state = LoadRouterState(*file, settings_.state_key, settings_.engine);
+    if (!state || state->vertex_count != vertex_count) {
+        return false;
+    }
+
+    // Размеры секций проверяются до того, как граф будет заменён
+    const size_t dimension = graph::BlockedRouter<double>::GetDimension(vertex_count);
+    const bool is_valid = settings_.engine == RouterEngine::BLOCKED_ALL_PAIRS
+        ? state->sections.size() == 2
+            && state->sections[0].size == dimension * dimension * sizeof(double)
+            && state->sections[1].size == dimension * dimension * sizeof(graph::EdgeId)
+        : state->sections.size() == 1
+            && state->sections[0].size == vertex_count * vertex_count * sizeof(graph::CompactRouter<double>::CompactEdgeId);
+    if (!is_valid) {
+        return false;
+    }
+    // По name_id ответ берёт остановку или маршрут из каталога: поездка и
+    // высадка несут номер маршрута, ожидание, посадка и переход — остановки
+    const size_t stop_count = catalogue.GetAllStops().size();
+    const size_t bus_count = catalogue.GetAllBuses().size();
+    for (const auto& edge : state->edges) {
+        const bool is_bus_edge = edge.span_count != WALK_SPAN_COUNT
+            && (edge.span_count > 0 || !IsStopVertex(edge.from));
+        if (edge.name_id >= (is_bus_edge ? bus_count : stop_count)) {
+            return false;
+        }
+    }
+    // Таблицы путей проверяются целиком, чтобы повреждённый файл был
+    // пересчитан, а не оборвал или исказил ответ. В блочной таблице путь
+    // есть ровно там, где вес конечен.
+    if (settings_.engine == RouterEngine::BLOCKED_ALL_PAIRS) {
+        constexpr graph::EdgeId NO_EDGE = graph::BlockedRouter<double>::NO_EDGE;
+        const auto* weights = static_cast<const double*>(state->sections[0].data);
+        const auto* prev_edges = static_cast<const graph::EdgeId*>(state->sections[1].data);
+        for (size_t from = 0; from < vertex_count; ++from) {
+            for (size_t to = 0; to < vertex_count; ++to) {
+                const double weight = weights[from * dimension + to];
+                const bool is_consistent = from == to
+                    ? weight == 0.0
+                    : std::isinf(weight) == (prev_edges[from * dimension + to] == NO_EDGE);
+                if (!is_consistent) {
+                    return false;
                 }
             }
         }
+        const bool is_table_valid = IsValidPrevEdgeTable(state->edges, vertex_count, NO_EDGE,
+            [&](graph::VertexId from, graph::VertexId to) {
+                return prev_edges[from * dimension + to];
+            });
+        if (!is_table_valid) {
+            return false;
+        }
+    } else {
+        using CompactRouter = graph::CompactRouter<double>;
+        const auto* table = static_cast<const CompactRouter::CompactEdgeId*>(state->sections[0].data);
+        const bool is_table_valid = IsValidPrevEdgeTable(state->edges, vertex_count, CompactRouter::NO_EDGE,
+            [&](graph::VertexId from, graph::VertexId to) {
+                return table[from * vertex_count + to];
+            });
+        if (!is_table_valid) {
+            return false;
+        }
+    }
+
+    graph::DirectedWeightedGraph<double> stops_graph(vertex_count);
+    for (const auto& edge : state->edges) {
+        stops_graph.AddEdge(edge);
+    }
+    stops_graph.Freeze();
+    topology_ = std::move(stops_graph);
+
+    // Таблица профиля по умолчанию берётся из файла, веса — пересчётом
+    auto profile = std::make_unique<Profile>(settings_.route_cache_size);
+    profile->parameters = {settings_.bus_wait_time, settings_.bus_velocity};
+    profile->graph = MakeProfileGraph(profile->parameters);
+    if (settings_.engine == RouterEngine::BLOCKED_ALL_PAIRS) {
+        profile->router = std::make_unique<graph::BlockedRouter<double>>(
+            profile->graph,
+            static_cast<const double*>(state->sections[0].data),
+            static_cast<const graph::EdgeId*>(state->sections[1].data));
+    } else {
+        profile->router = std::make_unique<graph::CompactRouter<double>>(
+            profile->graph,
+            static_cast<const graph::CompactRouter<double>::CompactEdgeId*>(state->sections[0].data));
+    }
+    profiles_[""] = std::move(profile);
+    state_file_ = std::move(file);
+    return true;
+}
+
+void Router::SaveState(const std::vector<StateSection>& sections) const {
+    if (IsStatePersistent()
+        && !SaveRouterState(settings_.state_file, settings_.state_key, settings_.engine, topology_, sections)) {
+        std::cerr << "Warning: failed to save router state to " << settings_.state_file << "\n";
+    }
+}
+
+std::vector<graph::Edge<double>> Router::MakeBusEdges(const transport_catalogue::Bus& bus,
+                                                      const transport_catalogue::TransportCatalogue& catalogue) const {
+    const auto& stops = bus.stops;
+    const size_t stops_count = stops.size();
+
+    // Префиксные суммы расстояний: forward[i] — путь от первой остановки до i-й,
+    // backward[i] — путь от i-й до первой в обратном направлении. Расстояние
+    // между любыми двумя остановками — разность двух префиксов. Буферы
+    // переиспользуются всеми маршрутами, которые обрабатывает поток.
+    thread_local std::vector<int> forward;
+    thread_local std::vector<int> backward;
+    thread_local std::vector<graph::VertexId> vertices;
+    forward.assign(stops_count, 0);
+    backward.assign(stops_count, 0);
+    vertices.resize(stops_count);
+    for (size_t k = 0; k < stops_count; ++k) {
+        vertices[k] = stop_vertices_[stops[k]];
+        if (k > 0) {
+            forward[k] = forward[k - 1] + catalogue.GetDistance(stops[k - 1], stops[k]);
+            backward[k] = backward[k - 1] + catalogue.GetDistance(stops[k], stops[k - 1]);
+        }
+    }
+
+    std::vector<graph::Edge<double>> edges;
+    edges.reserve(bus.is_round_trip ? stops_count * stops_count / 2 : stops_count * stops_count);
+    for (size_t i = 0; i < stops_count; ++i) {
+        for (size_t j = i + 1; j < stops_count; ++j) {
+            // Прямое ребро
+            AddBusEdge(edges, bus.id, j - i, vertices[i], vertices[j], forward[j] - forward[i]);
+
+            // Для некольцевых маршрутов добавляем обратное ребро
+            if (!bus.is_round_trip) {
+                AddBusEdge(edges, bus.id, j - i, vertices[j], vertices[i], backward[j] - backward[i]);
+            }
+        }
+    }
+    return edges;
+}
+
+std::vector<std::vector<transport_catalogue::StopIndex::NearbyStop>> Router::FindWalkNeighbours(
+        const transport_catalogue::TransportCatalogue& catalogue) const {
+    if (!(settings_.walk_radius > 0.0)) {
+        return {};
     }
-    
-    graph_ = std::move(stops_graph);
-    router_ = std::make_unique<graph::Router<double>>(graph_);
-}
-
-void Router::AddBusEdge(graph::DirectedWeightedGraph<double>& graph,
-                       const std::string& bus_name,
-                       size_t span_count,  
-                       const std::string& from_stop,
-                       const std::string& to_stop,
-                       double distance,
-                       double velocity) const {
-    double time = distance / velocity;
-    graph.AddEdge({
-        bus_name,
-        span_count,  
-        stop_ids_.at(from_stop) + 1,
-        stop_ids_.at(to_stop),
-        time
+    // Кандидаты берутся из пространственного индекса каталога: O(log n) плюс
+    // размер ответа на остановку вместо перебора всех пар
+    const auto& stop_index = catalogue.GetStopIndex();
+    const auto& stops = catalogue.GetAllStops();
+    std::vector<std::vector<transport_catalogue::StopIndex::NearbyStop>> walk_neighbours(stops.size());
+    parallel::ParallelFor(stops.size(), [&](size_t stop_id) {
+        auto neighbours = stop_index.FindWithinRadius(stops[stop_id].coordinates, settings_.walk_radius);
+        neighbours.erase(std::remove_if(neighbours.begin(), neighbours.end(), [stop_id](const auto& neighbour) {
+            return neighbour.id == stop_id;
+        }), neighbours.end());
+        walk_neighbours[stop_id] = std::move(neighbours);
     });
+    return walk_neighbours;
+}
+
+size_t Router::GetPatternVertexCount(const transport_catalogue::Bus& bus) {
+    return bus.is_round_trip ? bus.stops.size() : bus.stops.size() * 2;
 }
 
-std::optional<RouteInfo> Router::GetRouteInfo(std::string_view stop_from, std::string_view stop_to) const {
-    if (!router_) {
+std::vector<graph::Edge<double>> Router::MakePatternEdges(const transport_catalogue::Bus& bus,
+                                                          const transport_catalogue::TransportCatalogue& catalogue,
+                                                          graph::VertexId first_vertex) const {
+    const auto& stops = bus.stops;
+    const size_t stops_count = stops.size();
+
+    const std::vector<int> segments = catalogue.GetSegmentDistances(stops);
+    const std::vector<int> reverse_segments = catalogue.GetReverseSegmentDistances(stops);
+    std::vector<graph::Edge<double>> edges;
+    edges.reserve(GetPatternVertexCount(bus) * 3);
+    // Вершина first + k — пассажир в автобусе на k-й остановке направления.
+    // С остановки можно сесть везде, кроме последней, сойти — везде, кроме
+    // первой; поездка между соседними остановками — ребро в один пролёт.
+    const auto add_direction = [&](graph::VertexId first, bool is_backward) {
+        for (size_t k = 0; k < stops_count; ++k) {
+            const size_t position = is_backward ? stops_count - 1 - k : k;
+            const transport_catalogue::StopId stop = stops[position];
+            const graph::VertexId stop_vertex = stop_vertices_[stop];
+            if (k + 1 < stops_count) {
+                // Пролёт к следующей остановке направления; против хода — обратное расстояние
+                const int distance = is_backward ? reverse_segments[position - 1] : segments[position];
+                edges.push_back({stop, 0, stop_vertex, first + k, 0.0});
+                edges.push_back({
+                    bus.id,
+                    1,
+                    first + k,
+                    first + k + 1,
+                    static_cast<double>(distance)
+                });
+            }
+            if (k > 0) {
+                edges.push_back({bus.id, 0, first + k, stop_vertex, 0.0});
+            }
+        }
+    };
+    add_direction(first_vertex, false);
+    if (!bus.is_round_trip) {
+        add_direction(first_vertex + stops_count, true);
+    }
+    return edges;
+}
+
+void Router::AddBusEdge(std::vector<graph::Edge<double>>& edges,
+                        transport_catalogue::BusId bus_id,
+                        size_t span_count,
+                        graph::VertexId from_stop,
+                        graph::VertexId to_stop,
+                        double distance) const {
+    // В общем графе вес ребра поездки — расстояние, время задаёт профиль
+    edges.push_back({
+        bus_id,
+        static_cast<uint32_t>(span_count),
+        from_stop + 1,
+        to_stop,
+        distance
+    });
+}
+
+std::optional<RouteInfo> Router::GetRouteInfo(transport_catalogue::StopId stop_from, transport_catalogue::StopId stop_to,
+                                              std::string_view profile_name) const {
+    const Profile* profile = FindProfile(profile_name);
+    if (!profile) {
+        return std::nullopt;
+    }
+
+    const auto from = FindStopVertex(stop_from);
+    const auto to = FindStopVertex(stop_to);
+    if (!from || !to) {
+        return GetUnservedRoute(stop_from, stop_to);
+    }
+    const std::pair vertices{*from, *to};
+    if (auto cached = profile->route_cache.Get(vertices)) {
+        return std::move(*cached);
+    }
+    auto result = profile->raptor
+        ? profile->raptor->BuildRoute(vertices.first, vertices.second)
+        : MakeRouteInfo(*profile, profile->router->BuildRoute(vertices.first, vertices.second));
+    profile->route_cache.Put(vertices, result);
+    return result;
+}
+
+std::vector<std::optional<RouteInfo>> Router::GetRouteInfos(transport_catalogue::StopId stop_from,
+                                                            const std::vector<transport_catalogue::StopId>& stops_to,
+                                                            std::string_view profile_name) const {
+    std::vector<std::optional<RouteInfo>> results(stops_to.size());
+    const Profile* profile = FindProfile(profile_name);
+    if (!profile) {
+        return results;
+    }
+
+    const auto from_vertex = FindStopVertex(stop_from);
+    std::vector<graph::VertexId> targets;
+    std::vector<size_t> target_indices;
+    for (size_t i = 0; i < stops_to.size(); ++i) {
+        const auto to_vertex = FindStopVertex(stops_to[i]);
+        if (!from_vertex || !to_vertex) {
+            results[i] = GetUnservedRoute(stop_from, stops_to[i]);
+            continue;
+        }
+        const graph::VertexId from = *from_vertex;
+        const graph::VertexId to = *to_vertex;
+        if (auto cached = profile->route_cache.Get({from, to})) {
+            results[i] = std::move(*cached);
+        } else {
+            targets.push_back(to);
+            target_indices.push_back(i);
+        }
+    }
+    if (targets.empty()) {
+        return results;
+    }
+
+    auto routes = FindRoutes(*profile, *from_vertex, targets);
+    for (size_t k = 0; k < targets.size(); ++k) {
+        auto& result = results[target_indices[k]];
+        result = std::move(routes[k]);
+        profile->route_cache.Put({*from_vertex, targets[k]}, result);
+    }
+    return results;
+}
+
+std::optional<graph::VertexId> Router::FindStopVertex(transport_catalogue::StopId stop_id) const {
+    if (stop_id >= stop_vertices_.size() || stop_vertices_[stop_id] == NO_VERTEX) {
         return std::nullopt;
     }
+    return stop_vertices_[stop_id];
+}
+
+std::optional<RouteInfo> Router::GetUnservedRoute(transport_catalogue::StopId stop_from,
+                                                  transport_catalogue::StopId stop_to) {
+    // Из остановки вне графа можно «доехать» только до неё самой
+    if (stop_from == stop_to) {
+        return RouteInfo{};
+    }
+    return std::nullopt;
+}
+
+std::vector<std::optional<RouteInfo>> Router::FindRoutes(const Profile& profile, graph::VertexId from,
+                                                         const std::vector<graph::VertexId>& targets) const {
+    if (profile.raptor) {
+        const std::vector<transport_catalogue::StopId> stop_targets(targets.begin(), targets.end());
+        return profile.raptor->BuildRoutes(static_cast<transport_catalogue::StopId>(from), stop_targets);
+    }
+    auto routes = profile.router->BuildRoutes(from, targets);
+    std::vector<std::optional<RouteInfo>> results;
+    results.reserve(routes.size());
+    for (const auto& route : routes) {
+        results.push_back(MakeRouteInfo(profile, route));
+    }
+    return results;
+}
+
+cache::CacheStats Router::GetCacheStats() const {
+    cache::CacheStats stats;
+    for (const auto& [name, profile] : profiles_) {
+        const auto profile_stats = profile->route_cache.GetStats();
+        stats.hits += profile_stats.hits;
+        stats.misses += profile_stats.misses;
+        stats.size += profile_stats.size;
+    }
+    return stats;
+}
+
+graph::SearchStats Router::GetSearchStats() const {
+    graph::SearchStats stats;
+    for (const auto& [name, profile] : profiles_) {
+        if (!profile->router) {
+            continue;
+        }
+        const auto profile_stats = profile->router->GetSearchStats();
+        stats.queries += profile_stats.queries;
+        stats.settled_vertices += profile_stats.settled_vertices;
+    }
+    return stats;
+}
 
-    auto route = router_->BuildRoute(
-        stop_ids_.at(std::string(stop_from)),
-        stop_ids_.at(std::string(stop_to))
-    );
+uint64_t Router::GetCatalogueVersion() const {
+    return catalogue_version_;
+}
 
+std::optional<RouteInfo> Router::MakeRouteInfo(const Profile& profile,
+                                               const std::optional<graph::RouteInfo<double>>& route) const {
     if (!route) {
         return std::nullopt;
     }
 
     RouteInfo result;
     result.total_time = route->weight;
+    result.items.reserve(route->edges.size());
 
     for (const auto edge_id : route->edges) {
-        const auto& edge = graph_.GetEdge(edge_id);
+        const auto& edge = profile.graph.GetEdge(edge_id);
+        if (edge.span_count == WALK_SPAN_COUNT) {
+            result.items.push_back(WalkItem{edge.name_id, edge.weight});
+            continue;
+        }
         if (edge.span_count == 0) {
-            result.items.push_back(WaitItem{edge.name, edge.weight});
+            // Высадка в модели маршрутов только завершает поездку
+            if (IsStopVertex(edge.from)) {
+                result.items.push_back(WaitItem{edge.name_id, edge.weight});
+            }
+            continue;
+        }
+        // Подряд идущие рёбра поездки — пролёты одной цепочки маршрута,
+        // в ответе это одна поездка (в модели пар так не бывает)
+        BusItem* bus_item = result.items.empty() ? nullptr : std::get_if<BusItem>(&result.items.back());
+        if (bus_item && bus_item->bus_id == edge.name_id) {
+            bus_item->span_count += edge.span_count;
+            bus_item->time += edge.weight;
         } else {
-            result.items.push_back(BusItem{edge.name, edge.span_count, edge.weight});
+            result.items.push_back(BusItem{edge.name_id, edge.span_count, edge.weight});
         }
     }
 
@@ -1,63 +1,213 @@
 #pragma once
 
-#include "router.h"
+#include "lru_cache.h"
+#include "route_engine.h"
 #include "transport_catalogue.h"
 
+#include <cstdint>
+#include <functional>
+#include <map>
 #include <memory>
 #include <optional>
 #include <vector>
 #include <string>
-#include <unordered_map>
+#include <string_view>
 #include <variant>
 
 namespace transport {
 
+// Элементы маршрута хранят идентификаторы из каталога; названия
+// подставляются только при формировании ответа
 struct WaitItem {
-    std::string stop_name;
+    transport_catalogue::StopId stop_id = 0;
     double time = 0.0;
 };
 
 struct BusItem {
-    std::string bus;
+    transport_catalogue::BusId bus_id = 0;
     size_t span_count = 0;
     double time = 0.0;
 };
 
+// Пеший переход к остановке stop_id
+struct WalkItem {
+    transport_catalogue::StopId stop_id = 0;
+    double time = 0.0;
+};
+
 struct RouteInfo {
     double total_time = 0.0;
-    std::vector<std::variant<WaitItem, BusItem>> items;
+    std::vector<std::variant<WaitItem, BusItem, WalkItem>> items;
 };
 
-struct RouterSettings {
+// Алгоритм, которым отвечают на запросы маршрутов
+enum class RouterEngine {
+    ALL_PAIRS,  // Флойд-Уоршелл при построении, O(1) на запрос, O(V^2) памяти
+    DIJKSTRA,   // Дейкстра на каждый запрос, O(E) памяти
+    CONTRACTION_HIERARCHIES,  // иерархии сжатия: быстрая подготовка и запросы
+    BLOCKED_ALL_PAIRS,        // блочный параллельный Флойд-Уоршелл, O(1) на запрос
+    COMPACT_ALL_PAIRS,        // все пары, только последние рёбра путей: 4 байта на пару
+    RAPTOR,                   // раунды по маршрутам каталога, без графа и предрасчёта
+    ALT,                      // A* с ориентирами: O(L*V) памяти, поиск направлен к цели
+    BIDIRECTIONAL_DIJKSTRA,   // Дейкстра навстречу из обеих вершин, без предрасчёта
+};
+
+std::optional<RouterEngine> ParseRouterEngine(std::string_view name);
+
+// Как маршруты автобусов представлены в графе
+enum class GraphModel {
+    // Ребро между каждой парой остановок маршрута: O(k^2) рёбер на маршрут
+    // из k остановок, зато любая поездка — одно ребро
+    STOP_PAIRS,
+    // Цепочка вершин «в автобусе» вдоль маршрута с рёбрами посадки (несут
+    // ожидание) и высадки: O(k) рёбер и вершин на маршрут. Вершин больше,
+    // поэтому модель подходит движкам без таблиц всех пар
+    ROUTE_PATTERNS,
+};
+
+std::optional<GraphModel> ParseGraphModel(std::string_view name);
+
+// Параметры профиля маршрутизации: от них зависят только веса рёбер
+struct RoutingProfile {
     int bus_wait_time = 0;
     double bus_velocity = 0.0;
 };
 
+struct RouterSettings {
+    int bus_wait_time = 0;     // профиль по умолчанию
+    double bus_velocity = 0.0;
+    RouterEngine engine = RouterEngine::ALL_PAIRS;
+    GraphModel graph_model = GraphModel::STOP_PAIRS;  // RAPTOR граф не строит
+    size_t route_cache_size = 16384;  // число запоминаемых ответов профиля, 0 — без кэша
+    bool fewest_transfers = false;    // минимум пересадок вместо минимума времени (только RAPTOR)
+    // Пешие переходы между остановками не дальше walk_radius метров по
+    // прямой, 0 — без них; скорость walk_velocity в км/ч (RAPTOR их не учитывает)
+    double walk_radius = 0.0;
+    double walk_velocity = 5.0;
+    // Файл с графом и таблицей движков BLOCKED_ALL_PAIRS и COMPACT_ALL_PAIRS
+    // для профиля по умолчанию: если ключ в нём совпадает с state_key (хеш
+    // исходных данных), таблица отображается в память вместо пересчёта,
+    // иначе файл перезаписывается
+    std::string state_file;
+    uint64_t state_key = 0;
+};
+
+class MappedFile;
+class RaptorRouter;
+struct StateSection;
+
+// Граф строится один раз с расстояниями вместо времени на рёбрах; каждый
+// профиль (пустое имя — профиль по умолчанию из настроек) получает свои
+// веса, движок и кэш ответов поверх общей структуры графа.
 class Router {
 public:
-    Router() = default;
-    
-    Router(const RouterSettings& settings, const transport_catalogue::TransportCatalogue& catalogue)
-        : settings_(settings) {
-        BuildGraph(catalogue);
-    }
+    Router();
+    Router(const RouterSettings& settings, const transport_catalogue::TransportCatalogue& catalogue);
+    ~Router();
+
+    // Добавляет профиль или меняет его параметры: O(E) на пересчёт весов
+    // плюс подготовка движка (для Дейкстры и RAPTOR её нет)
+    void SetProfile(const std::string& name, const RoutingProfile& profile);
+    std::optional<RoutingProfile> GetProfile(std::string_view name) const;
+
+    // Остановки задаются номерами каталога. Для неизвестного профиля маршрута нет
+    std::optional<RouteInfo> GetRouteInfo(transport_catalogue::StopId stop_from, transport_catalogue::StopId stop_to,
+                                          std::string_view profile = {}) const;
+    // Маршруты из одной остановки в несколько: промахи кэша считаются одним
+    // поиском движка. Ответы идут в порядке stops_to.
+    std::vector<std::optional<RouteInfo>> GetRouteInfos(transport_catalogue::StopId stop_from,
+                                                        const std::vector<transport_catalogue::StopId>& stops_to,
+                                                        std::string_view profile = {}) const;
 
-    std::optional<RouteInfo> GetRouteInfo(std::string_view stop_from, std::string_view stop_to) const;
+    // Сумма по всем профилям
+    cache::CacheStats GetCacheStats() const;
+    // Просмотренные движками вершины по всем профилям — для сравнения
+    // движков без предрасчёта; запросы, отвеченные из кэша, не учитываются
+    graph::SearchStats GetSearchStats() const;
+    // Версия каталога, по которой построен граф; при расхождении с
+    // текущей версией каталога роутер и его кэш нужно пересоздать
+    uint64_t GetCatalogueVersion() const;
 
 private:
+    struct VertexPairHasher {
+        size_t operator()(const std::pair<graph::VertexId, graph::VertexId>& vertices) const {
+            return std::hash<graph::VertexId>()(vertices.first * 0x9E3779B97F4A7C15ull ^ vertices.second);
+        }
+    };
+    using RouteCache = cache::ShardedLruCache<std::pair<graph::VertexId, graph::VertexId>,
+                                              std::optional<RouteInfo>, VertexPairHasher>;
+
+    struct Profile {
+        explicit Profile(size_t route_cache_size);
+        ~Profile();
+
+        RoutingProfile parameters;
+        graph::DirectedWeightedGraph<double> graph;  // время вместо расстояний
+        std::unique_ptr<graph::RouteEngine<double>> router;
+        std::unique_ptr<RaptorRouter> raptor;
+        // Готовые ответы, включая отсутствие маршрута
+        mutable RouteCache route_cache;
+    };
+
+    const Profile* FindProfile(std::string_view name) const;
+    // Для остановок вне графа (без маршрутов) вершины нет
+    std::optional<graph::VertexId> FindStopVertex(transport_catalogue::StopId stop_id) const;
+    static std::optional<RouteInfo> GetUnservedRoute(transport_catalogue::StopId stop_from,
+                                                     transport_catalogue::StopId stop_to);
+    std::unique_ptr<Profile> MakeProfile(const RoutingProfile& parameters, bool save_state) const;
+    graph::DirectedWeightedGraph<double> MakeProfileGraph(const RoutingProfile& parameters) const;
+    void MakeEngine(Profile& profile, bool save_state) const;
+
+    std::optional<RouteInfo> MakeRouteInfo(const Profile& profile,
+                                           const std::optional<graph::RouteInfo<double>>& route) const;
+    std::vector<std::optional<RouteInfo>> FindRoutes(const Profile& profile, graph::VertexId from,
+                                                     const std::vector<graph::VertexId>& targets) const;
+
     void BuildGraph(const transport_catalogue::TransportCatalogue& catalogue);
-    void AddBusEdge(graph::DirectedWeightedGraph<double>& graph,
-               const std::string& bus_name,
+    void BuildRaptor(const transport_catalogue::TransportCatalogue& catalogue);
+    bool IsStatePersistent() const;
+    bool LoadState(size_t vertex_count, const transport_catalogue::TransportCatalogue& catalogue);
+    void SaveState(const std::vector<StateSection>& sections) const;
+    std::vector<graph::Edge<double>> MakeBusEdges(const transport_catalogue::Bus& bus,
+                                                  const transport_catalogue::TransportCatalogue& catalogue) const;
+    // Цепочки вершин маршрута начинаются с first_vertex: сначала прямое
+    // направление, для некольцевого маршрута за ним обратное
+    std::vector<graph::Edge<double>> MakePatternEdges(const transport_catalogue::Bus& bus,
+                                                      const transport_catalogue::TransportCatalogue& catalogue,
+                                                      graph::VertexId first_vertex) const;
+    static size_t GetPatternVertexCount(const transport_catalogue::Bus& bus);
+    // Соседи каждой остановки в радиусе пешего перехода, по номеру остановки
+    std::vector<std::vector<transport_catalogue::StopIndex::NearbyStop>> FindWalkNeighbours(
+            const transport_catalogue::TransportCatalogue& catalogue) const;
+    // Вершины остановок идут первыми, за ними вершины «в автобусе»
+    bool IsStopVertex(graph::VertexId vertex) const {
+        return vertex < stop_vertex_count_;
+    }
+    void AddBusEdge(std::vector<graph::Edge<double>>& edges,
+               transport_catalogue::BusId bus_id,
                size_t span_count,
-               const std::string& from_stop,
-               const std::string& to_stop,
-               double distance,
-               double velocity) const;
+               graph::VertexId from_stop,
+               graph::VertexId to_stop,
+               double distance) const;
     
     RouterSettings settings_;
-    graph::DirectedWeightedGraph<double> graph_;
-    std::unordered_map<std::string, graph::VertexId> stop_ids_;
-    std::unique_ptr<graph::Router<double>> router_;
+    uint64_t catalogue_version_ = 0;
+    // Отображённый файл состояния; таблица движка может указывать в него
+    std::unique_ptr<MappedFile> state_file_;
+    // Рёбра ожидания (в модели маршрутов — посадки) и высадки с нулевым
+    // весом, рёбра поездок и пеших переходов с расстоянием в метрах
+    graph::DirectedWeightedGraph<double> topology_;
+    // Отметка рёбер пеших переходов в span_count; name_id у них — остановка назначения
+    static constexpr uint32_t WALK_SPAN_COUNT = static_cast<uint32_t>(-1);
+    size_t stop_vertex_count_ = 0;
+    // Структура маршрутов для RAPTOR, из неё копируются профили
+    std::unique_ptr<RaptorRouter> raptor_topology_;
+    // Вершина графа по номеру остановки (вершины назначаются в порядке
+    // локальности) или NO_VERTEX для остановки без маршрутов; для RAPTOR —
+    // номер самой остановки
+    static constexpr graph::VertexId NO_VERTEX = static_cast<graph::VertexId>(-1);
+    std::vector<graph::VertexId> stop_vertices_;
+    std::map<std::string, std::unique_ptr<Profile>, std::less<>> profiles_;
 };
 
 } // namespace transport
\ No newline at end of file